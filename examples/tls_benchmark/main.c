@@ -0,0 +1,170 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/*
+ *  Compares the TLS profiles (see glitchedhttps_tls_profile.h) against a server of your choice:
+ *
+ *      handshakes: a bunch of HEAD requests (every request does a full TLS handshake, so this is mostly handshake time).
+ *      bulk:       one GET request whose (streamed) body is counted and thrown away.
+ *
+ *  Usage: glitchedhttps_example_tls_benchmark <HEAD URL> <bulk download URL> [handshake count]
+ *
+ *  Wall time is what the server round trips cost too, CPU time is what the client's crypto costs:
+ *  run it a few times against a server close by to get numbers that mean something.
+ */
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <glitchedhttps.h>
+
+static double now_ms()
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static double cpu_ms()
+{
+    return (double)clock() / CLOCKS_PER_SEC * 1000.0;
+}
+
+static int count_body(const char* data, size_t length, void* userdata)
+{
+    (void)data;
+    *(size_t*)userdata += length;
+    return 0;
+}
+
+static int benchmark_handshakes(const char* url, const int count)
+{
+    struct glitchedhttps_request request;
+    glitchedhttps_request_init(&request);
+
+    request.url = (char*)url;
+    request.method = GLITCHEDHTTPS_HEAD;
+
+    struct glitchedhttps_response* response = NULL;
+
+    const double wall_begin = now_ms();
+    const double cpu_begin = cpu_ms();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int result = glitchedhttps_submit_into(&request, &response);
+        if (result != GLITCHEDHTTPS_SUCCESS)
+        {
+            printf("    handshakes: request #%d failed with %d\n", i + 1, result);
+            glitchedhttps_response_free(response);
+            return result;
+        }
+    }
+
+    const double wall = now_ms() - wall_begin;
+    const double cpu = cpu_ms() - cpu_begin;
+
+    printf("    handshakes: %d requests, %.2f ms wall / %.2f ms CPU per request\n", count, wall / count, cpu / count);
+
+    glitchedhttps_response_free(response);
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+static int benchmark_bulk(const char* url)
+{
+    size_t received = 0;
+
+    struct glitchedhttps_request request;
+    glitchedhttps_request_init(&request);
+
+    request.url = (char*)url;
+    request.method = GLITCHEDHTTPS_GET;
+    request.buffer_size = 64 * 1024;
+    request.on_body = &count_body;
+    request.userdata = &received;
+
+    struct glitchedhttps_response* response = NULL;
+
+    const double wall_begin = now_ms();
+    const double cpu_begin = cpu_ms();
+
+    const int result = glitchedhttps_submit(&request, &response);
+
+    const double wall = now_ms() - wall_begin;
+    const double cpu = cpu_ms() - cpu_begin;
+
+    if (result != GLITCHEDHTTPS_SUCCESS)
+    {
+        printf("    bulk: request failed with %d\n", result);
+    }
+    else
+    {
+        const double megabytes = (double)received / (1024.0 * 1024.0);
+        printf("    bulk: %.2f MiB in %.2f ms wall (%.2f MiB/s), %.2f ms CPU (%.2f MiB/s)\n", megabytes, wall, megabytes / (wall / 1000.0), cpu, cpu > 0 ? megabytes / (cpu / 1000.0) : 0.0);
+    }
+
+    glitchedhttps_response_free(response);
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <HEAD URL> <bulk download URL> [handshake count]\n", argv[0]);
+        return 1;
+    }
+
+    const int handshakes = argc > 3 ? atoi(argv[3]) : 20;
+    if (handshakes <= 0)
+    {
+        fprintf(stderr, "The handshake count needs to be a positive number.\n");
+        return 1;
+    }
+
+    const enum glitchedhttps_tls_profile profiles[] = {
+        GLITCHEDHTTPS_TLS_PROFILE_COMPAT,
+        GLITCHEDHTTPS_TLS_PROFILE_THROUGHPUT,
+        GLITCHEDHTTPS_TLS_PROFILE_LOW_POWER,
+    };
+
+    if (glitchedhttps_init() != 0)
+    {
+        fprintf(stderr, "glitchedhttps_init() failed!\n");
+        return 1;
+    }
+
+    printf("\nHardware accelerated AES: %s (the \"auto\" profile picks \"%s\")\n\n",
+           glitchedhttps_tls_has_aes_acceleration() ? "yes" : "no",
+           glitchedhttps_tls_profile_name(glitchedhttps_tls_profile_resolve(GLITCHEDHTTPS_TLS_PROFILE_AUTO)));
+
+    int failures = 0;
+
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); ++i)
+    {
+        glitchedhttps_set_tls_profile(profiles[i]);
+        printf("Profile \"%s\":\n", glitchedhttps_tls_profile_name(profiles[i]));
+
+        failures += benchmark_handshakes(argv[1], handshakes) != GLITCHEDHTTPS_SUCCESS;
+        failures += benchmark_bulk(argv[2]) != GLITCHEDHTTPS_SUCCESS;
+
+        printf("\n");
+    }
+
+    glitchedhttps_free();
+
+    return failures == 0 ? 0 : 1;
+}
@@ -52,6 +52,12 @@ extern "C" {
 #include "glitchedhttps_request.h"
 #include "glitchedhttps_response.h"
 #include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_stats.h"
+#include "glitchedhttps_decoder.h"
+#include "glitchedhttps_multipart.h"
+#include "glitchedhttps_url.h"
+#include "glitchedhttps_tls_profile.h"
+#include "glitchedhttps_chaincache.h"
 
 /**
  * Current version of the used GlitchedHTTPS library.
@@ -70,6 +76,21 @@ extern "C" {
 #define GLITCHEDHTTPS_STACK_BUFFERSIZE 8192
 #endif
 
+#ifndef GLITCHEDHTTPS_EXPECT_CONTINUE_TIMEOUT_MS
+/**
+ * How long (in milliseconds) to wait for the server's <code>100 Continue</code> before sending the body of an <code>Expect: 100-continue</code> request anyway
+ * (unless the request specifies its own glitchedhttps_request::expect_continue_timeout_ms).
+ */
+#define GLITCHEDHTTPS_EXPECT_CONTINUE_TIMEOUT_MS 1000
+#endif
+
+#ifndef GLITCHEDHTTPS_DEFAULT_TLS_PROFILE
+/**
+ * The TLS profile that glitchedhttps_init() configures (unless glitchedhttps_set_tls_profile() was called before).
+ */
+#define GLITCHEDHTTPS_DEFAULT_TLS_PROFILE GLITCHEDHTTPS_TLS_PROFILE_COMPAT
+#endif
+
 /**
  * Initializes the library's resources, allocating everything needed for making HTTPS requests that requires some warmup
  * (e.g. parsing the x509 CA root certificates into a mbedtls_x509_crt context only needs to be done once). <p>
@@ -85,6 +106,21 @@ GLITCHEDHTTPS_API int glitchedhttps_init();
  */
 GLITCHEDHTTPS_API void glitchedhttps_free();
 
+/**
+ * Sets which cipher suites and curves glitchedhttps prefers when negotiating a TLS connection (see the glitchedhttps_tls_profile enum). <p>
+ * If glitchedhttps is already initialized, this takes effect for the next request; otherwise it's applied by #glitchedhttps_init(). <p>
+ * \warning Don't call this while there are requests pending!
+ * @param profile The TLS profile to use. Pass <code>GLITCHEDHTTPS_TLS_PROFILE_AUTO</code> to pick one based on whether this CPU has hardware accelerated AES.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> (zero); <code>GLITCHEDHTTPS_INVALID_ARG</code> if \p profile isn't a valid profile.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_set_tls_profile(enum glitchedhttps_tls_profile profile);
+
+/**
+ * Gets the TLS profile that is in use (with <code>GLITCHEDHTTPS_TLS_PROFILE_AUTO</code> already resolved into the profile it picked).
+ * @return The TLS profile in use.
+ */
+GLITCHEDHTTPS_API enum glitchedhttps_tls_profile glitchedhttps_get_tls_profile();
+
 /**
  * Submits a given HTTP request and writes the server response into the provided output glitchedhttps_response instance. <p>
  * This allocates memory, so don't forget to {@link #glitchedhttps_response_free()} the output glitchedhttps_response instance after usage!!
@@ -94,6 +130,84 @@ GLITCHEDHTTPS_API void glitchedhttps_free();
  */
 GLITCHEDHTTPS_API int glitchedhttps_submit(const struct glitchedhttps_request* request, struct glitchedhttps_response** out);
 
+/**
+ * Submits a given HTTP request just like {@link #glitchedhttps_submit()}, but refills an existing glitchedhttps_response instead of allocating a new one. <p>
+ * The passed response is reset first (see glitchedhttps_response_reset()) and keeps its buffers: they're only grown if the new response needs more room than the previous ones.
+ * In a loop that keeps polling the same endpoint (with lazy headers, see glitchedhttps_request::lazy_headers), the response side of a request then doesn't allocate anything anymore once the buffers have grown large enough. <p>
+ * Example: <code>struct glitchedhttps_response* r = NULL; while (polling) { glitchedhttps_submit_into(&request, &r); ... } glitchedhttps_response_free(r);</code>
+ * @param request The glitchedhttps_request instance containing the request parameters and data (e.g. url, body, etc...).
+ * @param response Pointer to the glitchedhttps_response to refill. If it points to <code>NULL</code>, a new response is allocated (or taken from the thread's response pool, see glitchedhttps_response_recycle()).
+ * If the request fails, a passed response is left reset (but still allocated: it's still yours to free).
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> (zero) if the request was submitted successfully; <code>GLITCHEDHTTPS_{ERROR_ID}</code> if it failed (same as {@link #glitchedhttps_submit()}).
+ */
+GLITCHEDHTTPS_API int glitchedhttps_submit_into(const struct glitchedhttps_request* request, struct glitchedhttps_response** response);
+
+/**
+ * @brief A request template whose URL was parsed and whose request line and headers were serialized once up front (see glitchedhttps_prepare()).
+ */
+struct glitchedhttps_prepared;
+
+/**
+ * Prepares a request template for being submitted many times: the URL is parsed and the request line as well as all of the headers
+ * (including the {@link glitchedhttps_request::additional_headers}, the content type and the content encoding) are serialized right here, only once. <p>
+ * Every glitchedhttps_submit_prepared() call then only needs to add the body and any per-call headers. <p>
+ * The template request isn't referenced anymore afterwards (its strings and headers are copied); only its glitchedhttps_request::userdata pointer is kept as it is.
+ * @note Allocation is done for you: once you're done using this, call {@link #glitchedhttps_prepared_free()} on it to prevent memory leaks!
+ * @param request The request template. Its glitchedhttps_request::content is ignored (bodies are passed to glitchedhttps_submit_prepared()).
+ * @return The prepared request, or <code>NULL</code> if the request is invalid (e.g. malformed URL or unavailable body compression; see the error log) or if allocating it failed.
+ */
+GLITCHEDHTTPS_API struct glitchedhttps_prepared* glitchedhttps_prepare(const struct glitchedhttps_request* request);
+
+/**
+ * Submits a prepared request. <p>
+ * The prepared header block is sent as it is: if there's neither a body nor per-call headers, the request isn't even copied.
+ * A prepared request can be submitted from multiple threads at the same time.
+ * @param prepared The prepared request template (see glitchedhttps_prepare()).
+ * @param content [OPTIONAL] The request body to send with this call (only sent if the template request had a content type). Pass <code>NULL</code> for no body. Ignored if the template request has a glitchedhttps_request::read_body callback (the body is pulled from that instead).
+ * @param content_length Length of the \p content in bytes. If this is zero, <code>strlen(content)</code> is used. With a glitchedhttps_request::read_body callback, this is the length of the streamed body (zero for chunked transfer encoding).
+ * @param headers [OPTIONAL] Additional headers for this call only. Pass <code>NULL</code> if there's none.
+ * @param headers_count The amount of \p headers.
+ * @param response Where to write the response: if it points to <code>NULL</code>, a new response is written into it; otherwise, the response it points to is refilled (just like with glitchedhttps_submit_into()).
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> (zero) if the request was submitted successfully; <code>GLITCHEDHTTPS_{ERROR_ID}</code> if it failed (same as {@link #glitchedhttps_submit()}).
+ */
+GLITCHEDHTTPS_API int glitchedhttps_submit_prepared(const struct glitchedhttps_prepared* prepared, const char* content, size_t content_length, const struct glitchedhttps_header* headers, size_t headers_count, struct glitchedhttps_response** response);
+
+/**
+ * Frees a prepared request template that was created using glitchedhttps_prepare().
+ * @param prepared The prepared request to free.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_prepared_free(struct glitchedhttps_prepared* prepared);
+
+/**
+ * @brief A request destination whose URL was parsed and whose host was resolved only once (opaque; see glitchedhttps_endpoint_init()). <p>
+ * Point a request's glitchedhttps_request::endpoint to it and every submission skips the URL parsing and the DNS lookup.
+ */
+struct glitchedhttps_endpoint;
+
+/**
+ * Parses a URL and resolves its host right away, so that requests to it can reuse both (see glitchedhttps_request::endpoint). <p>
+ * The resolved addresses are kept for as long as the endpoint lives: if the host's addresses may change, create a new endpoint every now and then.
+ * An endpoint is never modified after it was created, so it can be used by multiple threads at the same time.
+ * @note Allocation is done for you: once you're done using this (and all of the requests and prepared requests that use it are done), call {@link #glitchedhttps_endpoint_free()} on it to prevent memory leaks!
+ * @param url The URL (it's copied).
+ * @param url_length The length of the \p url string. If this is zero, <code>strlen(url)</code> is used.
+ * @return The new endpoint, or <code>NULL</code> if the URL is invalid, the host couldn't be resolved or allocating the endpoint failed (see the error log).
+ */
+GLITCHEDHTTPS_API struct glitchedhttps_endpoint* glitchedhttps_endpoint_init(const char* url, size_t url_length);
+
+/**
+ * Gets an endpoint's parsed URL.
+ * @param endpoint The endpoint.
+ * @return The endpoint's URL components (views into the endpoint's copy of the URL); <code>NULL</code> if \p endpoint is <code>NULL</code>.
+ */
+GLITCHEDHTTPS_API const struct glitchedhttps_url* glitchedhttps_endpoint_get_url(const struct glitchedhttps_endpoint* endpoint);
+
+/**
+ * Frees an endpoint that was created using glitchedhttps_endpoint_init().
+ * @param endpoint The endpoint to free.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_endpoint_free(struct glitchedhttps_endpoint* endpoint);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
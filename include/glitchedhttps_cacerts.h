@@ -18,6 +18,13 @@ extern "C" {
 #include "chillbuff.h"
 #include "stddef.h"
 
+#ifndef GLITCHEDHTTPS_SYSTEM_CA_CERTS_DIR
+/**
+ * The directory where the operating system keeps its trusted CA certificates in the OpenSSL hashed directory layout (see glitchedhttps_set_ca_certs_dir()).
+ */
+#define GLITCHEDHTTPS_SYSTEM_CA_CERTS_DIR "/etc/ssl/certs"
+#endif
+
 /**
  * Gets a concatenated string of all trusted CA certificates (NUL-terminated <code>char*</code> string).
  * @return Concatenated string of all trusted CA certificates (NUL-terminated <code>char*</code> string).
@@ -30,6 +37,17 @@ GLITCHEDHTTPS_API const char* glitchedhttps_get_ca_certs();
  */
 GLITCHEDHTTPS_API size_t glitchedhttps_get_ca_certs_length();
 
+/**
+ * Gets the bundled CA certificates in DER format: they're converted from the PEM bundle inside <strong>\c glitchedhttps_cacerts.c</strong> at build time
+ * (by <strong>\c tools/glitchedhttps_cacerts_der.c</strong>) and linked into the library, so loading them needs neither base64 decoding nor any file I/O. <p>
+ * This is only available if the library was built with the <code>GLITCHEDHTTPS_EMBED_DER_CA_CERTS</code> CMake option (on by default; the compile definition is <code>GLITCHEDHTTPS_EMBEDDED_CA_CERTS</code>).
+ * @param lengths [OPTIONAL] Where to write the address of the array that holds the length of each DER certificate (in the order in which they appear in the blob).
+ * @param count [OPTIONAL] Where to write the amount of certificates.
+ * @return All DER certificates back to back (in one blob), or <code>NULL</code> if there are no embedded certificates or if custom CA certificates
+ * were set using glitchedhttps_set_custom_ca_certs() or glitchedhttps_set_ca_certs_dir() (those take precedence).
+ */
+GLITCHEDHTTPS_API const unsigned char* glitchedhttps_get_ca_certs_der(const size_t** lengths, size_t* count);
+
 /**
  * Makes GlitchedHTTPS use a custom set of trusted CA certificates. <p>
  * Check out the source file <strong>\c glitchedhttps_cacerts.c</strong> to find out more about how the \p ca_certs parameter should look like (in terms of format). <p>
@@ -38,6 +56,23 @@ GLITCHEDHTTPS_API size_t glitchedhttps_get_ca_certs_length();
  */
 GLITCHEDHTTPS_API void glitchedhttps_set_custom_ca_certs(char* ca_certs);
 
+/**
+ * Makes GlitchedHTTPS trust the CA certificates inside a directory that uses the OpenSSL hashed directory layout (one certificate per <code>&lt;subject hash&gt;.&lt;n&gt;</code> file, as created by <code>c_rehash</code> or <code>openssl rehash</code>)
+ * instead of its own bundle: pass {@link #GLITCHEDHTTPS_SYSTEM_CA_CERTS_DIR} to use the operating system's trust store (and thus pick up the distribution's CA updates). <p>
+ * If the library was built with <code>GLITCHEDHTTPS_LAZY_CA_CERTS</code>, nothing is read up front: a certificate file is only looked up (by the OpenSSL hash of the issuer name), read and parsed when a certificate chain that's being verified needs it.
+ * Otherwise, the whole directory is parsed in glitchedhttps_init(). <p>
+ * Custom CA certificates that were set using glitchedhttps_set_custom_ca_certs() take precedence over this.
+ * \note Just like glitchedhttps_set_custom_ca_certs(), call this <strong>BEFORE</strong> the first call to #glitchedhttps_init() !
+ * @param directory The certificate directory (NUL-terminated path, without a trailing slash). The string is not copied: it needs to stay valid until glitchedhttps_free() is called. Pass \c NULL to revert back to using the default glitchedhttps chain of CA certificates.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_set_ca_certs_dir(const char* directory);
+
+/**
+ * Gets the CA certificates directory that was set using glitchedhttps_set_ca_certs_dir().
+ * @return The CA certificates directory, or <code>NULL</code> if there is none (or if custom CA certificates were set using glitchedhttps_set_custom_ca_certs(), which take precedence).
+ */
+GLITCHEDHTTPS_API const char* glitchedhttps_get_ca_certs_dir();
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
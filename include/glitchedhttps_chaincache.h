@@ -0,0 +1,122 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_chaincache.h
+ *  @brief Optional cache of server certificate chains that were already verified against the trust store, so that connecting to the same host again doesn't re-verify the whole chain (see glitchedhttps_set_verified_chain_cache_ttl()).
+ */
+
+#ifndef GLITCHEDHTTPS_CHAINCACHE_H
+#define GLITCHEDHTTPS_CHAINCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include <stdint.h>
+
+#ifndef GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_SIZE
+/**
+ * How many verified certificate chains each thread remembers (the least recently verified one is evicted first).
+ */
+#define GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_SIZE 32
+#endif
+
+#ifndef GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_TTL
+/**
+ * Default time to live (in seconds) of a verified certificate chain: <code>0</code> means that the cache is disabled (see glitchedhttps_set_verified_chain_cache_ttl()).
+ */
+#define GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_TTL 0
+#endif
+
+/**
+ * The length of a verified chain cache key (a SHA-256 hash).
+ */
+#define GLITCHEDHTTPS_CHAINCACHE_KEY_SIZE 32
+
+struct mbedtls_x509_crt;
+
+/**
+ * Enables the verified certificate chain cache: once a server's certificate chain was successfully verified against the trust store (including the host name check),
+ * later handshakes with that same host that present the exact same chain (byte by byte: the cache is keyed by the SHA-256 of the host name and all certificates the server sent)
+ * skip the chain verification (and thus all of its signature checks) for up to \p seconds. <p>
+ * A cached chain never outlives the earliest expiry date of its certificates. The handshake itself (and thus the proof that the server owns the leaf certificate's private key) is never skipped. <p>
+ * Each thread has its own cache. Everything in there is forgotten on glitchedhttps_free(). <p>
+ * \note The server certificate chain is verified right after the handshake instead of during it when the cache is enabled (a failed verification still fails the request before anything is sent).
+ * The checks that mbedtls does on top of the chain verification (the server certificate's key usage for the negotiated cipher suite and its key's curve) are repeated on every handshake, cached chain or not.
+ * This needs mbedtls 2 keeping the peer certificate around after the handshake (<code>MBEDTLS_SSL_KEEP_PEER_CERTIFICATE</code>, which is on by default): without it (and with mbedtls 3), the cache stays disabled.
+ * @param seconds How long (in seconds) a verified chain may be trusted without verifying it again. Pass <code>0</code> to disable the cache.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_set_verified_chain_cache_ttl(uint32_t seconds);
+
+/**
+ * Gets the verified certificate chain cache's time to live (see glitchedhttps_set_verified_chain_cache_ttl()).
+ * @return The time to live in seconds (<code>0</code> if the cache is disabled).
+ */
+GLITCHEDHTTPS_API uint32_t glitchedhttps_get_verified_chain_cache_ttl();
+
+/**
+ * @private
+ * Sets the time to live behind glitchedhttps_set_verified_chain_cache_ttl() (which also switches the shared SSL config over to verifying the chains after the handshake).
+ * @param seconds The time to live in seconds (<code>0</code> disables the cache).
+ */
+GLITCHEDHTTPS_API void glitchedhttps_chaincache_set_ttl(uint32_t seconds);
+
+/**
+ * @private
+ * Checks whether the verified chain cache is in use: it is enabled and the linked mbedtls (2) keeps the peer certificate chain around after the handshake.
+ * @return <code>1</code> if the server certificate chains should be verified (and cached) after the handshake; <code>0</code> if mbedtls should verify them during the handshake as usual.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_chaincache_enabled();
+
+/**
+ * @private
+ * Computes the cache key of a server certificate chain: the SHA-256 of the host name and every certificate in the chain (in the order in which the server sent them).
+ * @param host The host name that the chain is verified against (NUL-terminated string).
+ * @param chain The server's certificate chain (leaf first).
+ * @param key Where to write the {@link #GLITCHEDHTTPS_CHAINCACHE_KEY_SIZE} bytes long key into.
+ * @return <code>0</code> on success; the mbedtls error code if hashing failed.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_chaincache_key(const char* host, const struct mbedtls_x509_crt* chain, unsigned char* key);
+
+/**
+ * @private
+ * Looks up a chain in the calling thread's cache.
+ * @param key The chain's cache key (see glitchedhttps_chaincache_key()).
+ * @return <code>1</code> if the chain was verified before and that verification is still fresh (within the time to live and before the earliest expiry date of the chain's certificates); <code>0</code> if it needs to be verified.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_chaincache_lookup(const unsigned char* key);
+
+/**
+ * @private
+ * Remembers a chain that was just successfully verified in the calling thread's cache.
+ * @param key The chain's cache key (see glitchedhttps_chaincache_key()).
+ * @param chain The verified chain (only its certificates' expiry dates are stored).
+ */
+GLITCHEDHTTPS_API void glitchedhttps_chaincache_store(const unsigned char* key, const struct mbedtls_x509_crt* chain);
+
+/**
+ * @private
+ * Forgets all verified chains (of all threads): this is called on glitchedhttps_free(), since the trust store that they were verified against might change.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_chaincache_clear();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_CHAINCACHE_H
@@ -0,0 +1,101 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_chunked.h
+ *  @brief Single-pass decoder for HTTP/1.1's chunked transfer encoding. Mostly for internal use!
+ */
+
+#ifndef GLITCHEDHTTPS_CHUNKED_H
+#define GLITCHEDHTTPS_CHUNKED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include <stddef.h>
+
+#ifndef GLITCHEDHTTPS_CHUNKED_MAX_LINE_LENGTH
+/**
+ * The maximum length in bytes of a single chunk-size line (including chunk extensions) or trailer line.
+ */
+#define GLITCHEDHTTPS_CHUNKED_MAX_LINE_LENGTH 8192
+#endif
+
+/**
+ * Callback through which the chunked decoder reports trailer fields (with their name and trimmed value). <p>
+ * Chunk extensions are validated but never reported: a server could otherwise send as many of them as it likes (one per chunk).
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> to continue decoding; any other glitchedhttps exit code aborts decoding and is returned from glitchedhttps_chunked_decode().
+ */
+typedef int (*glitchedhttps_chunked_header_callback)(void* ctx, const char* type, size_t type_length, const char* value, size_t value_length);
+
+/**
+ * @brief State of a chunked transfer decoder. It can be fed with input of any size and keeps track of where it left off in between calls.
+ */
+struct glitchedhttps_chunked_decoder
+{
+    /** @private */
+    int state;
+
+    /** @private Bytes of the current chunk's data that are still to come. */
+    size_t chunk_remaining;
+
+    /** @private Where a chunk-size or trailer line that was split across two inputs is reassembled. */
+    char line[GLITCHEDHTTPS_CHUNKED_MAX_LINE_LENGTH];
+
+    /** @private */
+    size_t line_length;
+
+    /** @private */
+    glitchedhttps_chunked_header_callback on_header;
+
+    /** @private */
+    void* on_header_ctx;
+};
+
+/**
+ * Initializes (or resets) a glitchedhttps_chunked_decoder.
+ * @param decoder The decoder to initialize.
+ * @param on_header [OPTIONAL] Callback that receives the trailer fields. Pass <code>NULL</code> to discard them.
+ * @param on_header_ctx Context pointer to pass into \p on_header.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_chunked_decoder_init(struct glitchedhttps_chunked_decoder* decoder, glitchedhttps_chunked_header_callback on_header, void* on_header_ctx);
+
+/**
+ * Decodes chunked transfer encoded data <strong>in place</strong>: all of \p data is consumed and the decoded body bytes
+ * are compacted towards its beginning (the output only advances together with the input, by the chunk data bytes that were just read, while the framing advances the input alone: so the output never overtakes the input). <p>
+ * Every input byte is looked at exactly once, and binary chunk data (NUL bytes and all) is moved with <code>memmove()</code>.
+ * @param decoder The decoder state (initialize it with glitchedhttps_chunked_decoder_init() before the first call).
+ * @param data The chunked data to decode. Its decoded body bytes are written to <code>data[0]</code> to <code>data[*out_length - 1]</code>.
+ * @param length How many bytes of \p data to decode.
+ * @param out_length Where to write the amount of decoded body bytes.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> on success; <code>GLITCHEDHTTPS_RESPONSE_PARSE_ERROR</code> if the data isn't valid chunked encoding; or whatever the header callback returned if that failed.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_chunked_decode(struct glitchedhttps_chunked_decoder* decoder, char* data, size_t length, size_t* out_length);
+
+/**
+ * Checks whether a glitchedhttps_chunked_decoder has seen the final (zero-sized) chunk and the end of the trailer section.
+ * @param decoder The decoder to check.
+ * @return <code>1</code> if the chunked body is complete; <code>0</code> if more data is expected.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_chunked_decoder_done(const struct glitchedhttps_chunked_decoder* decoder);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_CHUNKED_H
@@ -0,0 +1,184 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_decoder.h
+ *  @brief Registry of streaming content decoders (gzip, deflate, br, zstd, ...) for transparently decompressing response bodies.
+ */
+
+#ifndef GLITCHEDHTTPS_DECODER_H
+#define GLITCHEDHTTPS_DECODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include <stddef.h>
+
+#ifndef GLITCHEDHTTPS_MAX_CONTENT_DECODERS
+/**
+ * How many content decoders can be registered with glitchedhttps_register_content_decoder() (on top of the built-in ones).
+ */
+#define GLITCHEDHTTPS_MAX_CONTENT_DECODERS 16
+#endif
+
+#ifndef GLITCHEDHTTPS_MAX_CONTENT_CODINGS
+/**
+ * The maximum amount of content codings that can be chained in one Content-Encoding header (e.g. <code>"gzip, br"</code> is two of them).
+ */
+#define GLITCHEDHTTPS_MAX_CONTENT_CODINGS 4
+#endif
+
+#ifndef GLITCHEDHTTPS_DECODER_CHUNK_SIZE
+/**
+ * How many decoded bytes the built-in decoders produce (and pass on to their output callback) at once.
+ */
+#define GLITCHEDHTTPS_DECODER_CHUNK_SIZE 16384
+#endif
+
+/**
+ * Receives a content decoder's output.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> to continue decoding; any other glitchedhttps exit code aborts decoding (the decoder should return it as it is).
+ */
+typedef int (*glitchedhttps_decoder_output_callback)(void* ctx, const char* data, size_t length);
+
+/**
+ * @brief A streaming content decoder for one content coding (e.g. "gzip").
+ */
+struct glitchedhttps_content_decoder
+{
+    /**
+     * The content coding's name as it appears in Content-Encoding/Accept-Encoding headers (e.g. "gzip", "br", "zstd"). Compared case-insensitively.
+     */
+    const char* name;
+
+    /**
+     * Allocates and initializes a fresh decoding state for one response body.
+     * @return <code>GLITCHEDHTTPS_SUCCESS</code> on success; any other glitchedhttps exit code on failure.
+     */
+    int (*init)(void** state);
+
+    /**
+     * Decodes the next piece of encoded input (of any size) and passes all output that's ready on to \p output.
+     * @return <code>GLITCHEDHTTPS_SUCCESS</code> on success; <code>GLITCHEDHTTPS_DECOMPRESSION_FAILED</code> if the input is invalid; or whatever \p output returned if that failed.
+     */
+    int (*update)(void* state, const char* data, size_t length, glitchedhttps_decoder_output_callback output, void* output_ctx);
+
+    /**
+     * Called once the whole body has been passed into update(): flushes any remaining output and checks that the encoded data was complete.
+     * @return <code>GLITCHEDHTTPS_SUCCESS</code> on success; <code>GLITCHEDHTTPS_DECOMPRESSION_FAILED</code> if the encoded data was truncated; or whatever \p output returned if that failed.
+     */
+    int (*finish)(void* state, glitchedhttps_decoder_output_callback output, void* output_ctx);
+
+    /**
+     * Frees a decoding state that was created by init() (called in any case, no matter whether decoding succeeded or not).
+     */
+    void (*free)(void* state);
+};
+
+/**
+ * Registers a content decoder, so that response bodies encoded with its content coding can be decoded transparently
+ * (and so that it's advertised in the Accept-Encoding header of requests that have glitchedhttps_request::decompress_response set). <p>
+ * Decoders registered like this take precedence over built-in ones with the same name. <p>
+ * The registry is not synchronized: register your decoders once at startup, before submitting any requests.
+ * @param decoder The decoder to register. It's not copied, so it needs to stay valid for as long as glitchedhttps is used (e.g. a <code>static const</code> struct).
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> on success; <code>GLITCHEDHTTPS_NULL_ARG</code> or <code>GLITCHEDHTTPS_INVALID_ARG</code> if the decoder is incomplete; <code>GLITCHEDHTTPS_OVERFLOW</code> if #GLITCHEDHTTPS_MAX_CONTENT_DECODERS were already registered.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_register_content_decoder(const struct glitchedhttps_content_decoder* decoder);
+
+/**
+ * Finds the content decoder for a content coding (registered decoders first, then the built-in ones).
+ * @param name The content coding (e.g. "gzip"). Does not need to be NUL-terminated.
+ * @param name_length The length of \p name.
+ * @return The decoder, or <code>NULL</code> if the content coding is not supported.
+ */
+GLITCHEDHTTPS_API const struct glitchedhttps_content_decoder* glitchedhttps_find_content_decoder(const char* name, size_t name_length);
+
+/**
+ * Writes the value of an Accept-Encoding header that lists all of the supported content codings (e.g. <code>"zstd, br, gzip, deflate"</code>) into the passed buffer.
+ * @param out Where to write the NUL-terminated header value into.
+ * @param out_size The size of the \p out buffer.
+ * @return The length of the written header value (<code>0</code> if no content decoders are available or if the buffer is too small).
+ */
+GLITCHEDHTTPS_API size_t glitchedhttps_get_accept_encoding(char* out, size_t out_size);
+
+/** @private */
+struct glitchedhttps_decoding_pipeline;
+
+/** @private */
+struct glitchedhttps_decoding_stage
+{
+    const struct glitchedhttps_content_decoder* decoder;
+    void* state;
+    struct glitchedhttps_decoding_pipeline* pipeline;
+    size_t index;
+};
+
+/**
+ * @private
+ * Chain of content decoders for one response body, in decoding order (the reverse of the order in which the codings are listed in the Content-Encoding header).
+ * Every stage's output is fed straight into the next one; the last stage's output goes to the pipeline's output callback. <p>
+ * Stages refer back to their pipeline, so an initialized pipeline must not be moved around in memory.
+ */
+struct glitchedhttps_decoding_pipeline
+{
+    struct glitchedhttps_decoding_stage stages[GLITCHEDHTTPS_MAX_CONTENT_CODINGS];
+    size_t count;
+    glitchedhttps_decoder_output_callback output;
+    void* output_ctx;
+};
+
+/**
+ * @private
+ * Sets up a decoding pipeline for a Content-Encoding header value.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> if every listed content coding can be decoded (the pipeline's stage count is <code>0</code> if there's nothing to decode);
+ * <code>GLITCHEDHTTPS_INVALID_ARG</code> if one of them isn't supported (the body then needs to be passed on as it is); or any other exit code if a decoder failed to initialize.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_decoding_pipeline_init(struct glitchedhttps_decoding_pipeline* pipeline, const char* content_encoding, size_t content_encoding_length, glitchedhttps_decoder_output_callback output, void* output_ctx);
+
+/** @private */
+GLITCHEDHTTPS_API int glitchedhttps_decoding_pipeline_update(struct glitchedhttps_decoding_pipeline* pipeline, const char* data, size_t length);
+
+/** @private */
+GLITCHEDHTTPS_API int glitchedhttps_decoding_pipeline_finish(struct glitchedhttps_decoding_pipeline* pipeline);
+
+/** @private */
+GLITCHEDHTTPS_API void glitchedhttps_decoding_pipeline_free(struct glitchedhttps_decoding_pipeline* pipeline);
+
+#ifdef GLITCHEDHTTPS_ENABLE_ZLIB
+/** @private Built-in gzip decoder (zlib). */
+extern const struct glitchedhttps_content_decoder glitchedhttps_gzip_decoder;
+
+/** @private Built-in deflate decoder (zlib); accepts both zlib-wrapped and raw deflate data. */
+extern const struct glitchedhttps_content_decoder glitchedhttps_deflate_decoder;
+#endif
+
+#ifdef GLITCHEDHTTPS_ENABLE_BROTLI
+/** @private Built-in brotli decoder. */
+extern const struct glitchedhttps_content_decoder glitchedhttps_brotli_decoder;
+#endif
+
+#ifdef GLITCHEDHTTPS_ENABLE_ZSTD
+/** @private Built-in zstd decoder. */
+extern const struct glitchedhttps_content_decoder glitchedhttps_zstd_decoder;
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_DECODER_H
@@ -0,0 +1,93 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_encoder.h
+ *  @brief Streaming content encoders for compressing request bodies on the fly while they're being sent.
+ */
+
+#ifndef GLITCHEDHTTPS_ENCODER_H
+#define GLITCHEDHTTPS_ENCODER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include <stddef.h>
+
+#ifndef GLITCHEDHTTPS_ENCODER_CHUNK_SIZE
+/**
+ * How many compressed bytes the built-in encoders produce (and pass on to their output callback) at once.
+ * This is also the maximum size of the chunks in which a compressed request body is sent.
+ */
+#define GLITCHEDHTTPS_ENCODER_CHUNK_SIZE 16384
+#endif
+
+/**
+ * @brief Content codings that request bodies can be compressed with (see glitchedhttps_request::compress_content).
+ */
+enum glitchedhttps_content_coding
+{
+    /** Send the request body as it is. */
+    GLITCHEDHTTPS_CODING_IDENTITY = 0,
+
+    /** gzip (requires glitchedhttps to be built with the optional zlib component). */
+    GLITCHEDHTTPS_CODING_GZIP = 1,
+
+    /** zstd (requires glitchedhttps to be built with the optional zstd component). */
+    GLITCHEDHTTPS_CODING_ZSTD = 2
+};
+
+/**
+ * Receives a content encoder's output.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> to continue encoding; any other glitchedhttps exit code aborts encoding (the encoder should return it as it is).
+ */
+typedef int (*glitchedhttps_encoder_output_callback)(void* ctx, const char* data, size_t length);
+
+/**
+ * @brief A streaming content encoder for one content coding (e.g. "gzip").
+ */
+struct glitchedhttps_content_encoder
+{
+    /** The content coding's name as it goes into the request's Content-Encoding header. */
+    const char* name;
+
+    /** Allocates and initializes a fresh encoding state for one request body. */
+    int (*init)(void** state);
+
+    /** Compresses the next piece of the body (of any size) and passes whatever output is ready on to \p output. */
+    int (*update)(void* state, const char* data, size_t length, glitchedhttps_encoder_output_callback output, void* output_ctx);
+
+    /** Called after the whole body has been passed into update(): flushes the rest of the compressed output. */
+    int (*finish)(void* state, glitchedhttps_encoder_output_callback output, void* output_ctx);
+
+    /** Frees a state created by init(). */
+    void (*free)(void* state);
+};
+
+/**
+ * Gets the built-in encoder for a content coding.
+ * @param coding The content coding.
+ * @return The encoder; <code>NULL</code> if \p coding is <code>GLITCHEDHTTPS_CODING_IDENTITY</code> or if glitchedhttps was built without the component that it needs.
+ */
+GLITCHEDHTTPS_API const struct glitchedhttps_content_encoder* glitchedhttps_get_content_encoder(enum glitchedhttps_content_coding coding);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_ENCODER_H
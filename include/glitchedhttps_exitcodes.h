@@ -106,6 +106,27 @@ extern "C" {
  */
 #define GLITCHEDHTTPS_EMPTY_RESPONSE 1300
 
+/**
+ * Returned if one of the request's callbacks (e.g. glitchedhttps_request::on_headers or glitchedhttps_request::on_body) returned non-zero to abort the request.
+ */
+#define GLITCHEDHTTPS_ABORTED_BY_CALLBACK 1400
+
+/**
+ * Returned if the response body couldn't be written to the request's glitchedhttps_request::output_fd.
+ */
+#define GLITCHEDHTTPS_OUTPUT_WRITE_FAILED 1500
+
+/**
+ * Returned if a compressed response body couldn't be decompressed (invalid or truncated gzip/deflate/br/zstd data).
+ */
+#define GLITCHEDHTTPS_DECOMPRESSION_FAILED 1600
+
+/**
+ * Returned if the request's glitchedhttps_request::read_body callback failed (returned a negative value),
+ * or if it delivered less data than announced in glitchedhttps_request::content_length.
+ */
+#define GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED 1700
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -28,6 +28,7 @@ extern "C" {
 
 #include "glitchedhttps_api.h"
 #include <stddef.h>
+#include <string.h>
 
 /**
  * @brief HTTP request (or response) header (for example: type="Authorization" ; value="Basic YWxhZGRpbjpvcGVuc2VzYW1l").
@@ -45,14 +46,82 @@ struct glitchedhttps_header
      * This MUST be a NUL-terminated C-string!
      */
     char* value;
+
+    /**
+     * The length of the {@link #type} string (without its NUL-terminator). <p>
+     * If this is zero, <code>strlen(type)</code> is used: headers that come from glitchedhttps (responses, glitchedhttps_header_init() and glitchedhttps_header_list) always have it set.
+     */
+    size_t type_length;
+
+    /**
+     * The length of the {@link #value} string (without its NUL-terminator). <p>
+     * If this is zero, <code>strlen(value)</code> is used (which is also correct for empty values).
+     */
+    size_t value_length;
+};
+
+/**
+ * @brief A growable list of headers whose strings all live in one single backing buffer (with their lengths recorded), ready to be passed to a glitchedhttps_request. <p>
+ * Pass {@link #headers} and {@link #headers_count} as the request's glitchedhttps_request::additional_headers and glitchedhttps_request::additional_headers_count
+ * (re-read them after adding headers: adding may move both arrays).
+ * @see glitchedhttps_header_list_init()
+ */
+struct glitchedhttps_header_list
+{
+    /** The headers. Their strings point into {@link #buffer} and are NUL-terminated. */
+    struct glitchedhttps_header* headers;
+
+    /** The amount of headers in the list. */
+    size_t headers_count;
+
+    /** @private Capacity (in elements) of the {@link #headers} array. */
+    size_t headers_capacity;
+
+    /** @private The buffer that holds all of the header strings back to back. */
+    char* buffer;
+
+    /** @private Used length of the {@link #buffer}. */
+    size_t buffer_length;
+
+    /** @private Capacity of the {@link #buffer}. */
+    size_t buffer_capacity;
 };
 
+/**
+ * @brief Well-known HTTP header names that glitchedhttps recognizes with one single lookup (see {@link #glitchedhttps_header_lookup()}).
+ */
+enum glitchedhttps_header_name
+{
+    GLITCHEDHTTPS_HEADER_UNKNOWN = 0,
+    GLITCHEDHTTPS_HEADER_SERVER = 1,
+    GLITCHEDHTTPS_HEADER_DATE = 2,
+    GLITCHEDHTTPS_HEADER_CONTENT_TYPE = 3,
+    GLITCHEDHTTPS_HEADER_CONTENT_ENCODING = 4,
+    GLITCHEDHTTPS_HEADER_CONTENT_LENGTH = 5,
+    GLITCHEDHTTPS_HEADER_TRANSFER_ENCODING = 6,
+    GLITCHEDHTTPS_HEADER_CONNECTION = 7,
+    GLITCHEDHTTPS_HEADER_KEEP_ALIVE = 8,
+    GLITCHEDHTTPS_HEADER_ETAG = 9,
+    GLITCHEDHTTPS_HEADER_CACHE_CONTROL = 10,
+    GLITCHEDHTTPS_HEADER_LOCATION = 11
+};
+
+/**
+ * Identifies a header name (case-insensitively) as one of the well-known glitchedhttps_header_name entries. <p>
+ * The name's length and first character select exactly one candidate among the well-known header names
+ * (a perfect hash over them), so recognizing a header costs one switch and at most one string comparison.
+ * @param name The header name to look up (e.g. "content-length"). Does not need to be NUL-terminated.
+ * @param name_length The length of the \p name string.
+ * @return The matching glitchedhttps_header_name, or <code>GLITCHEDHTTPS_HEADER_UNKNOWN</code> if the name isn't one of the well-known ones.
+ */
+GLITCHEDHTTPS_API enum glitchedhttps_header_name glitchedhttps_header_lookup(const char* name, size_t name_length);
+
 /**
  * Creates and initializes a glitchedhttps_header instance and returns its pointer. <p>
  * @note Allocation is done for you: once you're done using this MAKE SURE to call {@link #glitchedhttps_header_free()} on it to prevent memory leaks!
- * @param type The header type name (e.g. "Authorization", "Accept", etc...). Must be a NUL-terminated string!
+ * @param type The header type name (e.g. "Authorization", "Accept", etc...). Doesn't need to be NUL-terminated.
  * @param type_length The length of the header type string.
- * @param value The header value (NUL-terminated string).
+ * @param value The header value. Doesn't need to be NUL-terminated.
  * @param value_length The length of the header value string.
  * @return The freshly allocated and initialized glitchedhttps_header instance (a pointer to it). If init failed, <code>NULL</code> is returned!
  */
@@ -64,6 +133,55 @@ GLITCHEDHTTPS_API struct glitchedhttps_header* glitchedhttps_header_init(const c
  */
 GLITCHEDHTTPS_API void glitchedhttps_header_free(struct glitchedhttps_header* header);
 
+/**
+ * Gets the length of a header's type string (its glitchedhttps_header::type_length, or <code>strlen(type)</code> if that's zero).
+ * @param header The header.
+ * @return The length of the header type string.
+ */
+static inline size_t glitchedhttps_header_type_length(const struct glitchedhttps_header* header)
+{
+    return header->type_length > 0 ? header->type_length : strlen(header->type);
+}
+
+/**
+ * Gets the length of a header's value string (its glitchedhttps_header::value_length, or <code>strlen(value)</code> if that's zero).
+ * @param header The header.
+ * @return The length of the header value string.
+ */
+static inline size_t glitchedhttps_header_value_length(const struct glitchedhttps_header* header)
+{
+    return header->value_length > 0 ? header->value_length : strlen(header->value);
+}
+
+/**
+ * Initializes an empty glitchedhttps_header_list (nothing is allocated until the first header is added).
+ * @param list The header list to initialize.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_header_list_init(struct glitchedhttps_header_list* list);
+
+/**
+ * Appends a header to a glitchedhttps_header_list: both strings are copied into the list's backing buffer (NUL-terminated) and their lengths are recorded.
+ * @param list The header list to append to.
+ * @param type The header type name (e.g. "Authorization"). Doesn't need to be NUL-terminated.
+ * @param type_length The length of the \p type string. If this is zero, <code>strlen(type)</code> is used.
+ * @param value The header value. Doesn't need to be NUL-terminated.
+ * @param value_length The length of the \p value string. If this is zero, <code>strlen(value)</code> is used.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> if the header was added; <code>GLITCHEDHTTPS_NULL_ARG</code>, <code>GLITCHEDHTTPS_INVALID_ARG</code> (empty header type) or <code>GLITCHEDHTTPS_OUT_OF_MEM</code> if not.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_header_list_add(struct glitchedhttps_header_list* list, const char* type, size_t type_length, const char* value, size_t value_length);
+
+/**
+ * Removes all headers from a glitchedhttps_header_list, but keeps its memory around for reuse.
+ * @param list The header list to clear.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_header_list_clear(struct glitchedhttps_header_list* list);
+
+/**
+ * Frees the memory owned by a glitchedhttps_header_list (the list itself is left in an empty, reusable state).
+ * @param list The header list whose memory to free.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_header_list_free(struct glitchedhttps_header_list* list);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -0,0 +1,108 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_multipart.h
+ *  @brief Builder for <code>multipart/form-data</code> request bodies that are streamed out of memory and files (without ever assembling the whole body).
+ */
+
+#ifndef GLITCHEDHTTPS_MULTIPART_H
+#define GLITCHEDHTTPS_MULTIPART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include "glitchedhttps_request.h"
+#include <stddef.h>
+
+/**
+ * @brief A <code>multipart/form-data</code> body under construction (opaque; see glitchedhttps_multipart_init()). <p>
+ * Only the small part header sections are serialized when parts are added: in-memory parts are referenced and file parts are only opened while they're being sent.
+ * The total size is known up front, so the body is sent with a regular <code>Content-Length</code> header.
+ */
+struct glitchedhttps_multipart;
+
+/**
+ * Creates a new, empty multipart body with a freshly generated boundary.
+ * @note Allocation is done for you: once you're done using this, call {@link #glitchedhttps_multipart_free()} on it to prevent memory leaks!
+ * @return The new multipart body, or <code>NULL</code> if allocating it failed.
+ */
+GLITCHEDHTTPS_API struct glitchedhttps_multipart* glitchedhttps_multipart_init();
+
+/**
+ * Adds an in-memory part (e.g. a form field or a small piece of metadata). <p>
+ * The \p data is <strong>not</strong> copied: it needs to stay valid (and unchanged) until the request that sends this body was submitted.
+ * @param multipart The multipart body to add the part to.
+ * @param name The form field name (NUL-terminated).
+ * @param data The part's content (binary-safe).
+ * @param data_length The length of \p data in bytes. If this is zero, <code>strlen(data)</code> is used.
+ * @param content_type [OPTIONAL] The part's content type (e.g. "application/json"). Pass <code>NULL</code> to leave it out (plain text form field).
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> if the part was added; <code>GLITCHEDHTTPS_NULL_ARG</code> or <code>GLITCHEDHTTPS_OUT_OF_MEM</code> if not.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_multipart_add_data(struct glitchedhttps_multipart* multipart, const char* name, const char* data, size_t data_length, const char* content_type);
+
+/**
+ * Adds a file part. <p>
+ * The file's size is determined right away (for the body's <code>Content-Length</code>), but its content is only read while the request is being sent:
+ * the file is read straight into the send buffer, one send buffer at a time (with <code>pread()</code>, or <code>fread()</code> on Windows).
+ * The file must not change its size until the request was sent (if it does, the request fails with <code>GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED</code>).
+ * @param multipart The multipart body to add the part to.
+ * @param name The form field name (NUL-terminated).
+ * @param path The path of the file to send (NUL-terminated).
+ * @param filename [OPTIONAL] The file name to tell the server. Pass <code>NULL</code> to use the last component of \p path.
+ * @param content_type [OPTIONAL] The file's content type. Pass <code>NULL</code> for "application/octet-stream".
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> if the part was added; <code>GLITCHEDHTTPS_NULL_ARG</code>, <code>GLITCHEDHTTPS_INVALID_ARG</code> (file not found) or <code>GLITCHEDHTTPS_OUT_OF_MEM</code> if not.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_multipart_add_file(struct glitchedhttps_multipart* multipart, const char* name, const char* path, const char* filename, const char* content_type);
+
+/**
+ * Gets the total size of the multipart body in bytes (including all boundaries and part headers).
+ * @param multipart The multipart body.
+ * @return The body's exact length in bytes.
+ */
+GLITCHEDHTTPS_API size_t glitchedhttps_multipart_content_length(const struct glitchedhttps_multipart* multipart);
+
+/**
+ * Gets the body's content type: <code>multipart/form-data; boundary=...</code>
+ * @param multipart The multipart body.
+ * @return The NUL-terminated content type string (owned by the multipart body).
+ */
+GLITCHEDHTTPS_API const char* glitchedhttps_multipart_content_type(const struct glitchedhttps_multipart* multipart);
+
+/**
+ * Sets up a request to send the multipart body: its glitchedhttps_request::read_body, glitchedhttps_request::userdata,
+ * glitchedhttps_request::content_length and glitchedhttps_request::content_type are overwritten. <p>
+ * The body is read from the start again every time this is called (so a multipart body can be sent more than once, but not by two requests at the same time).
+ * Don't add any more parts after attaching the body to a request.
+ * @param multipart The multipart body to send.
+ * @param request The request to send it with.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> or <code>GLITCHEDHTTPS_NULL_ARG</code>.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_multipart_attach(struct glitchedhttps_multipart* multipart, struct glitchedhttps_request* request);
+
+/**
+ * Frees a multipart body that was created using glitchedhttps_multipart_init() (the in-memory part data it references is left alone).
+ * @param multipart The multipart body to free.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_multipart_free(struct glitchedhttps_multipart* multipart);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_MULTIPART_H
@@ -30,6 +30,19 @@ extern "C" {
 #include <string.h>
 #include "glitchedhttps_api.h"
 #include "glitchedhttps_method.h"
+#include "glitchedhttps_encoder.h"
+
+struct glitchedhttps_response;
+struct glitchedhttps_endpoint;
+
+/**
+ * Callback that supplies a request body piece by piece while it's being sent (see glitchedhttps_request::read_body).
+ * @param buffer Where to write the next piece of the request body.
+ * @param capacity The maximum amount of bytes to write into \p buffer.
+ * @param userdata The request's glitchedhttps_request::userdata.
+ * @return How many bytes were written into \p buffer; <code>0</code> once the whole body was delivered; or a negative value to abort the request (with <code>GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED</code>).
+ */
+typedef ptrdiff_t (*glitchedhttps_body_source)(char* buffer, size_t capacity, void* userdata);
 
 /**
  * @brief Struct containing an HTTP request's parameters and headers.
@@ -66,7 +79,8 @@ struct glitchedhttps_request
     char* content;
 
     /**
-     * Content-Length header that tells the server how many bytes to read from the message body. If this is zero, <code>strlen(content)</code> will be used!
+     * Content-Length header that tells the server how many bytes to read from the message body. If this is zero, <code>strlen(content)</code> will be used! <p>
+     * Set this for binary request bodies (e.g. protobuf or images): exactly this many bytes of {@link #content} are sent, NUL bytes included.
      */
     size_t content_length;
 
@@ -93,7 +107,8 @@ struct glitchedhttps_request
     /**
      * [OPTIONAL] Additional headers for the HTTP request. <p>
      * Set this to <code>NULL</code> if you don't want to add any additional HTTP request headers. <p>
-     * You can create headers using the {@link #glitchedhttps_header_init()} function.
+     * You can create headers using the {@link #glitchedhttps_header_init()} function, or build a whole list of them in one single buffer with a glitchedhttps_header_list
+     * (headers with their glitchedhttps_header::type_length and glitchedhttps_header::value_length set are serialized without any <code>strlen()</code> calls).
      */
     struct glitchedhttps_header* additional_headers;
 
@@ -114,6 +129,104 @@ struct glitchedhttps_request
      * This value is only taken into consideration in case of an HTTPS request (determined by the scheme defined in the url). Plain HTTP requests ignore this setting.
      */
     int ssl_verification_optional;
+
+    /**
+     * [OPTIONAL] Called once the response's status line and headers have been received (before any of the body is passed to {@link #on_body}). <p>
+     * The passed glitchedhttps_response is still owned by glitchedhttps and only valid for the duration of the callback (its {@link glitchedhttps_response::content} is <code>NULL</code>).
+     * It isn't const so that it can be passed to glitchedhttps_response_get_header() and glitchedhttps_response_get_headers(), but don't free it or change its fields. <p>
+     * Return <code>0</code> to continue receiving the response; anything else aborts the request with <code>GLITCHEDHTTPS_ABORTED_BY_CALLBACK</code>. <p>
+     * This is only called if {@link #on_body} is set too.
+     */
+    int (*on_headers)(struct glitchedhttps_response* response, void* userdata);
+
+    /**
+     * [OPTIONAL] Streams the response body instead of buffering it: if this is set, every (decoded) piece of the response body is passed into this callback as soon as it's received,
+     * and glitchedhttps only ever holds one read buffer of {@link #buffer_size} bytes (instead of the whole response). <p>
+     * The output glitchedhttps_response will then have a <code>NULL</code> {@link glitchedhttps_response::content}, its {@link glitchedhttps_response::content_length} will be the total amount of body bytes
+     * that were passed into this callback and its {@link glitchedhttps_response::raw} only contains the response head. <p>
+     * The \p data is only valid for the duration of the callback. Return <code>0</code> to continue receiving; anything else aborts the request with <code>GLITCHEDHTTPS_ABORTED_BY_CALLBACK</code>.
+     */
+    int (*on_body)(const char* data, size_t length, void* userdata);
+
+    /**
+     * [OPTIONAL] User data to pass into the {@link #on_headers}, {@link #on_body} and {@link #read_body} callbacks.
+     */
+    void* userdata;
+
+    /**
+     * [OPTIONAL] Download the response body straight into this (already opened and writable) file descriptor. <p>
+     * Leave this at <code>0</code> to not use this (stdin is never a valid download target anyway). If this is set, {@link #on_body} is ignored, but {@link #on_headers} is still called. <p>
+     * The body never enters {@link glitchedhttps_response::content} (which stays <code>NULL</code>; {@link glitchedhttps_response::content_length} is the amount of bytes written to the file descriptor). <p>
+     * For plain <code>http://</code> URLs on Linux, the body is moved from the socket to the file descriptor using <code>splice()</code> (no copying through userspace) unless it uses chunked transfer encoding.
+     * For <code>https://</code> URLs the decrypted data is written to the file descriptor as it's received.
+     */
+    int output_fd;
+
+    /**
+     * [OPTIONAL] Set this to <code>1</code> if you're only interested in the response's status code and headers (e.g. for health checks and other "probe" requests). <p>
+     * The response is then considered complete as soon as its header section was received: the body is never read and the connection is closed right away. <p>
+     * Responses to <code>HEAD</code> requests and responses with status code 204 or 304 are always treated like this (they never have a body).
+     */
+    int headers_only;
+
+    /**
+     * [OPTIONAL] Set this to <code>1</code> to send an <code>Accept-Encoding</code> header listing all available content decoders (see glitchedhttps_decoder.h)
+     * and to transparently decode the response body if the server encoded it with (a chain of) those. <p>
+     * The body is decoded as it arrives: the decoded bytes land directly in {@link glitchedhttps_response::content} (or go to {@link #on_body}/{@link #output_fd}),
+     * and {@link glitchedhttps_response::content_encoding} is then <code>NULL</code> (the original <code>Content-Encoding</code> header is still in the response's header list). <p>
+     * Built-in decoders are available if glitchedhttps was built with the optional zlib (gzip, deflate), brotli (br) and/or zstd components
+     * (CMake options <code>glitchedhttps_ENABLE_ZLIB</code>, <code>glitchedhttps_ENABLE_BROTLI</code> and <code>glitchedhttps_ENABLE_ZSTD</code>);
+     * more can be added with glitchedhttps_register_content_decoder(). If no decoders are available at all, this flag is ignored.
+     */
+    int decompress_response;
+
+    /**
+     * [OPTIONAL] Compress the request body ({@link #content}) with this content coding on the fly while it's being sent. <p>
+     * The body is then sent using chunked transfer encoding (its compressed size isn't known up front), and the coding is appended to the
+     * request's <code>Content-Encoding</code> header (after {@link #content_encoding}, if you set that too). The compressed body never exists in memory as a whole. <p>
+     * Leave this at <code>GLITCHEDHTTPS_CODING_IDENTITY</code> to send the body as it is. <code>GLITCHEDHTTPS_CODING_GZIP</code> requires glitchedhttps to be built with the
+     * optional zlib component and <code>GLITCHEDHTTPS_CODING_ZSTD</code> with the zstd one; if the needed component is missing, glitchedhttps_submit() fails with <code>GLITCHEDHTTPS_INVALID_ARG</code>.
+     */
+    enum glitchedhttps_content_coding compress_content;
+
+    /**
+     * [OPTIONAL] Set this to <code>1</code> to parse the response headers lazily: while parsing the response, glitchedhttps then only records where each header line lies inside
+     * {@link glitchedhttps_response::raw}, and the header strings (plus {@link glitchedhttps_response::server}, {@link glitchedhttps_response::date} and {@link glitchedhttps_response::content_type})
+     * are only allocated the first time they're accessed through glitchedhttps_response_get_headers() or glitchedhttps_response_get_header(). <p>
+     * Callers that only look at the status code and the body then don't pay for the headers at all. <p>
+     * This only applies to buffered responses: when the body is streamed (via {@link #on_body} or {@link #output_fd}), the headers are always parsed right away for the {@link #on_headers} callback.
+     */
+    int lazy_headers;
+
+    /**
+     * [OPTIONAL] Pulls the request body out of this callback while it's being sent, instead of sending {@link #content} (which is then ignored). <p>
+     * This way, the body never needs to be in memory as a whole: the callback is asked for one buffer's worth of data at a time,
+     * and only once the previous piece was handed over to the socket (so a slow connection slows down the reading too). <p>
+     * If {@link #content_length} is set, exactly that many bytes are read from the callback (and announced in a <code>Content-Length</code> header);
+     * otherwise, the callback is read until it returns <code>0</code>. Bodies of unknown length (and bodies that are compressed with {@link #compress_content}) are sent using chunked transfer encoding. <p>
+     * The callback receives the request's {@link #userdata}. The {@link #content_type} is optional for streamed bodies.
+     */
+    glitchedhttps_body_source read_body;
+
+    /**
+     * [OPTIONAL] Set this to <code>1</code> to send the request with an <code>Expect: 100-continue</code> header: the request head is sent on its own first,
+     * and the body only follows once the server answered with <code>100 Continue</code>. If the server answers with its final response right away instead
+     * (e.g. <code>401 Unauthorized</code> or <code>413 Payload Too Large</code>), the body isn't sent at all and that response is returned. <p>
+     * If the server doesn't answer within {@link #expect_continue_timeout_ms}, the body is sent anyway (not every server knows about 100-continue). <p>
+     * This only applies to requests that have a body; it's worth it for big uploads that the server might reject.
+     */
+    int expect_continue;
+
+    /**
+     * [OPTIONAL] How long (in milliseconds) to wait for the server's <code>100 Continue</code> (see {@link #expect_continue}). If this is <code>0</code>, <code>GLITCHEDHTTPS_EXPECT_CONTINUE_TIMEOUT_MS</code> is used.
+     */
+    int expect_continue_timeout_ms;
+
+    /**
+     * [OPTIONAL] Where to send the request to, with the URL already parsed and the host already resolved (see glitchedhttps_endpoint_init()). <p>
+     * If this is set, {@link #url} is ignored. Requests that go to the same URL over and over again skip all of the URL parsing and DNS lookups this way.
+     */
+    const struct glitchedhttps_endpoint* endpoint;
 };
 
 /**
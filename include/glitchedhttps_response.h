@@ -29,6 +29,70 @@ extern "C" {
 #include "glitchedhttps_api.h"
 #include "glitchedhttps_header.h"
 
+/**
+ * @private
+ * Hash index over a glitchedhttps_response's headers (opaque; see glitchedhttps_response_get_header()).
+ */
+struct glitchedhttps_header_index;
+
+/**
+ * @private
+ * Where a not-yet-materialized header line lies inside a glitchedhttps_response's {@link glitchedhttps_response::raw} string (see glitchedhttps_request::lazy_headers).
+ */
+struct glitchedhttps_header_line
+{
+    /** Offset of the header line's first character inside the raw response. */
+    size_t offset;
+
+    /** Length of the header line (without its CRLF line ending). */
+    size_t length;
+};
+
+#ifndef GLITCHEDHTTPS_RESPONSE_POOL_SIZE
+/**
+ * The maximum amount of recycled responses that are kept around per thread (see glitchedhttps_response_recycle()).
+ */
+#define GLITCHEDHTTPS_RESPONSE_POOL_SIZE 4
+#endif
+
+/**
+ * @private
+ * Heap buffers of a glitchedhttps_response that survive glitchedhttps_response_reset(), so that refilling the response doesn't need to allocate them again. <p>
+ * Each capacity describes the live buffer (e.g. glitchedhttps_response::raw) while the response is filled, and the retained buffer in here after a reset.
+ */
+struct glitchedhttps_response_buffers
+{
+    /** Retained glitchedhttps_response::raw allocation. */
+    char* raw;
+
+    /** Size (in bytes) of the raw response buffer. */
+    size_t raw_capacity;
+
+    /** Retained glitchedhttps_response::content allocation. */
+    char* content;
+
+    /** Size (in bytes) of the content buffer. */
+    size_t content_capacity;
+
+    /** Retained glitchedhttps_response::headers array. */
+    struct glitchedhttps_header* headers;
+
+    /** Capacity (in elements) of the header array. */
+    size_t headers_capacity;
+
+    /** Retained glitchedhttps_response::header_lines array. */
+    struct glitchedhttps_header_line* header_lines;
+
+    /** Capacity (in elements) of the header line array. */
+    size_t header_lines_capacity;
+
+    /** Retained receive buffer (only ever in here: while a response is being received, the buffer belongs to the receiving code). */
+    char* receive_buffer;
+
+    /** Size (in bytes) of the receive buffer. */
+    size_t receive_buffer_capacity;
+};
+
 /**
  * @brief Struct containing an HTTP response's data.
  */
@@ -40,7 +104,8 @@ struct glitchedhttps_response
     /** The full, raw returned HTTP response in plain text, with carriage returns, line breaks, final NUL-terminator and everything... */
     char* raw;
 
-    /** The (NUL-terminated) response's server header string. */
+    /** The (NUL-terminated) response's server header string. <p>
+     * With glitchedhttps_request::lazy_headers, this (as well as {@link #date} and {@link #content_type}) is only filled in once the headers are materialized (see glitchedhttps_response_get_headers()). */
     char* server;
 
     /** Response timestamp in GMT (original string, with NUL-terminator at its end). */
@@ -52,19 +117,101 @@ struct glitchedhttps_response
     /** Response body encoding (e.g. "gzip"). NUL-terminated string. If there's no response body, this remains <code>NULL</code>. */
     char* content_encoding;
 
-    /** The response's content body (could be a JSON string, could be plain text; make sure to check out and acknowledge the "content_type" field before doing anything with this). */
+    /** The response's content body (could be a JSON string, could be plain text; make sure to check out and acknowledge the "content_type" field before doing anything with this). <p>
+     * The body is binary-safe: it's exactly {@link #content_length} bytes long and may contain NUL bytes (an extra NUL terminator is appended after it for convenience). */
     char* content;
 
     /** The response's content length header value. */
     size_t content_length;
 
-    /** All HTTP response headers. @see glitchedhttps_header */
+    /** All HTTP response headers. @see glitchedhttps_header <p>
+     * With glitchedhttps_request::lazy_headers, this only contains the chunked trailer fields (if any) until the headers are materialized: use glitchedhttps_response_get_headers() to access them. */
     struct glitchedhttps_header* headers;
 
     /** The total amount of headers included in the HTTP response. */
     size_t headers_count;
+
+    /** @private Case-insensitive hash index over {@link #headers}, built while parsing the response. Use glitchedhttps_response_get_header() to query it. */
+    struct glitchedhttps_header_index* header_index;
+
+    /** @private [Lazy headers only] Header lines inside {@link #raw} that weren't turned into glitchedhttps_header instances yet. <code>NULL</code> once the headers are materialized. */
+    struct glitchedhttps_header_line* header_lines;
+
+    /** @private [Lazy headers only] The amount of entries in {@link #header_lines}. */
+    size_t header_lines_count;
+
+    /** @private Buffers that are kept for the next time this response is refilled (see glitchedhttps_submit_into()). */
+    struct glitchedhttps_response_buffers buffers;
 };
 
+/**
+ * Gets all of the response's headers. <p>
+ * If the request was submitted with glitchedhttps_request::lazy_headers set, this is where the header strings (as well as the
+ * glitchedhttps_response::server, glitchedhttps_response::date and glitchedhttps_response::content_type fields) get allocated:
+ * until then, the response only knows where its header lines lie inside glitchedhttps_response::raw.
+ * @note Materializing lazy headers modifies the response (which is why this takes a non-const pointer): don't call the header accessors on the same lazily parsed response from multiple threads at once (unless one call already completed before).
+ * @param response The glitchedhttps_response whose headers to get.
+ * @param headers_count [OPTIONAL] Where to write the amount of headers (the length of the returned array). Pass <code>NULL</code> if you only need the header fields to be filled in.
+ * @return The response's header array (same as glitchedhttps_response::headers), or <code>NULL</code> if there are no headers (or if they couldn't be allocated).
+ */
+GLITCHEDHTTPS_API const struct glitchedhttps_header* glitchedhttps_response_get_headers(struct glitchedhttps_response* response, size_t* headers_count);
+
+/**
+ * Looks up a response header by its name (case-insensitively). <p>
+ * Responses returned by {@link #glitchedhttps_submit()} come with a small hash index over their headers, so this is an O(1) lookup. <p>
+ * Lazily parsed headers (see glitchedhttps_request::lazy_headers) are materialized on the first call (see glitchedhttps_response_get_headers()).
+ * @param response The glitchedhttps_response whose headers to search.
+ * @param name The header name to look for (e.g. "ETag", "X-RateLimit-Remaining", etc...).
+ * @param name_length The length of the \p name string. If this is zero, <code>strlen(name)</code> will be used!
+ * @return The first header with the given name (in the order in which it was received), or <code>NULL</code> if the response doesn't contain such a header.
+ */
+GLITCHEDHTTPS_API const struct glitchedhttps_header* glitchedhttps_response_get_header(struct glitchedhttps_response* response, const char* name, size_t name_length);
+
+/**
+ * Iterates over multi-valued headers: gets the next header that has the same name as the passed one. <p>
+ * Example: <code>for (h = glitchedhttps_response_get_header(r, "Set-Cookie", 0); h != NULL; h = glitchedhttps_response_next_header(r, h)) { ... }</code>
+ * @param response The glitchedhttps_response that the \p header belongs to.
+ * @param header The current header (as returned by glitchedhttps_response_get_header() or a previous call to this function).
+ * @return The next header with the same name, or <code>NULL</code> if there are no more headers with that name.
+ */
+GLITCHEDHTTPS_API const struct glitchedhttps_header* glitchedhttps_response_next_header(const struct glitchedhttps_response* response, const struct glitchedhttps_header* header);
+
+/**
+ * @private
+ * (Re)builds the hash index over the response's headers. Called by the response parser once all headers are known.
+ * @param response The glitchedhttps_response whose headers to index.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> on success; <code>GLITCHEDHTTPS_OUT_OF_MEM</code> if the index couldn't be allocated (lookups then fall back to a linear scan).
+ */
+GLITCHEDHTTPS_API int glitchedhttps_response_index_headers(struct glitchedhttps_response* response);
+
+/**
+ * Empties a glitchedhttps_response, so that it can be refilled by glitchedhttps_submit_into(): all of its fields are set back to zero/<code>NULL</code> (the status code to <code>-1</code>),
+ * but the response keeps its raw response, content, header array and receive buffers around, so that refilling it only needs to allocate if the next response turns out to be bigger. <p>
+ * glitchedhttps_submit_into() does this for you: you only need to call this if you want to drop a response's data early.
+ * @param response The glitchedhttps_response to reset.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_response_reset(struct glitchedhttps_response* response);
+
+/**
+ * Resets a glitchedhttps_response (see glitchedhttps_response_reset()) and puts it into the calling thread's response pool, from which glitchedhttps_submit() takes its output responses (buffers and all) before allocating new ones. <p>
+ * Use this instead of glitchedhttps_response_free() in loops that keep submitting requests and don't hold on to the responses. If the pool is full (see <code>GLITCHEDHTTPS_RESPONSE_POOL_SIZE</code>), the response is freed.
+ * @note The pool is per thread: call glitchedhttps_response_pool_clear() before a thread that recycled responses exits, or their memory is leaked.
+ * @param response The glitchedhttps_response to recycle. Don't use it anymore afterwards!
+ */
+GLITCHEDHTTPS_API void glitchedhttps_response_recycle(struct glitchedhttps_response* response);
+
+/**
+ * Frees all recycled responses in the calling thread's response pool (see glitchedhttps_response_recycle()).
+ */
+GLITCHEDHTTPS_API void glitchedhttps_response_pool_clear(void);
+
+/**
+ * @private
+ * Takes a response out of the calling thread's response pool.
+ * @return A reset glitchedhttps_response (with retained buffers), or <code>NULL</code> if the pool is empty.
+ */
+GLITCHEDHTTPS_API struct glitchedhttps_response* glitchedhttps_response_pool_take(void);
+
 /**
  * Frees an glitchedhttps_response instance that was allocated by {@link #glitchedhttps_submit()}.
  * @param response The glitchedhttps_response instance ready for deallocation.
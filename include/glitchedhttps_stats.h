@@ -0,0 +1,66 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_stats.h
+ *  @brief Process-wide counters that make glitchedhttps' internal memory traffic observable.
+ */
+
+#ifndef GLITCHEDHTTPS_STATS_H
+#define GLITCHEDHTTPS_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include <stdint.h>
+
+/**
+ * @brief Snapshot of the glitchedhttps statistics counters (see glitchedhttps_get_stats()).
+ */
+struct glitchedhttps_stats
+{
+    /**
+     * How many times a response receive buffer had to be grown (reallocated).
+     */
+    uint64_t receive_buffer_growths;
+
+    /**
+     * How many bytes of already received data were copied over while growing response receive buffers.
+     */
+    uint64_t receive_buffer_bytes_copied;
+};
+
+/**
+ * Gets a snapshot of the current statistics counters (they're counted since program start, or since the last call to glitchedhttps_reset_stats()).
+ * @param out Where to write the counters into.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_get_stats(struct glitchedhttps_stats* out);
+
+/**
+ * Resets all statistics counters to <code>0</code>.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_reset_stats();
+
+/** @private */
+GLITCHEDHTTPS_API void glitchedhttps_stats_count_receive_buffer_growth(uint64_t bytes_copied);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_STATS_H
@@ -27,6 +27,7 @@ extern "C" {
 #endif
 
 #include <ctype.h>
+#include <limits.h>
 #include <string.h>
 
 /**
@@ -36,7 +37,7 @@ extern "C" {
  * @param n How many characters of the string should be compared (starting from index 0)?
  * @return If the strings are equal, <code>0</code> is returned. Otherwise, something else.
  */
-GLITCHEDHTTPS_API int glitchedhttps_strncmpic(const char* str1, const char* str2, size_t n)
+static inline int glitchedhttps_strncmpic(const char* str1, const char* str2, size_t n)
 {
     size_t cmp = 0;
     int ret = INT_MIN;
@@ -60,6 +61,36 @@ GLITCHEDHTTPS_API int glitchedhttps_strncmpic(const char* str1, const char* str2
     return ret;
 }
 
+/**
+ * Converts an ASCII character to lowercase (locale-independent, unlike <code>tolower()</code>).
+ * @param c The character to convert.
+ * @return The lowercase version of \p c if it's an uppercase ASCII letter; \p c itself otherwise.
+ */
+static inline char glitchedhttps_tolower_ascii(const char c)
+{
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+/**
+ * Checks whether the first \p n characters of two strings are equal (ignoring ASCII UPPER vs. lowercase). <p>
+ * Other than glitchedhttps_strncmpic() this does not stop at NUL-terminators: both strings need to be at least \p n characters long!
+ * @param str1 String to compare.
+ * @param str2 String to compare to.
+ * @param n How many characters to compare.
+ * @return <code>1</code> if the strings are equal (case-insensitive); <code>0</code> if they aren't.
+ */
+static inline int glitchedhttps_strnequalic(const char* str1, const char* str2, const size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (glitchedhttps_tolower_ascii(str1[i]) != glitchedhttps_tolower_ascii(str2[i]))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
 /**
  * Checks whether a given string starts with <code>http://</code>.
  * @param url The URL string to check.
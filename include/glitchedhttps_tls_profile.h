@@ -0,0 +1,96 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_tls_profile.h
+ *  @brief Named TLS performance profiles: which cipher suites and elliptic curves glitchedhttps offers first (see glitchedhttps_set_tls_profile()).
+ */
+
+#ifndef GLITCHEDHTTPS_TLS_PROFILE_H
+#define GLITCHEDHTTPS_TLS_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+
+/**
+ * @brief TLS performance profile. <p>
+ * A profile only changes the order of preference: every profile still offers all of the other commonly supported cipher suites and curves
+ * after its preferred ones, so that servers with a narrower configuration can still be talked to.
+ */
+enum glitchedhttps_tls_profile
+{
+    /**
+     * The mbedtls defaults (all cipher suites and curves that mbedtls was built with, in its own order of preference).
+     */
+    GLITCHEDHTTPS_TLS_PROFILE_COMPAT = 0,
+
+    /**
+     * AES-GCM first (fastest bulk encryption when AES runs in hardware), ECDSA before RSA server keys (cheaper handshakes) and X25519 for the key exchange.
+     */
+    GLITCHEDHTTPS_TLS_PROFILE_THROUGHPUT = 1,
+
+    /**
+     * ChaCha20-Poly1305 first (fastest bulk encryption when AES has to run in software, e.g. without AES-NI), ECDSA before RSA server keys and X25519 for the key exchange.
+     */
+    GLITCHEDHTTPS_TLS_PROFILE_LOW_POWER = 2,
+
+    /**
+     * Picks {@link #GLITCHEDHTTPS_TLS_PROFILE_THROUGHPUT} if mbedtls runs AES in hardware on this CPU (see glitchedhttps_tls_has_aes_acceleration()), {@link #GLITCHEDHTTPS_TLS_PROFILE_LOW_POWER} otherwise.
+     */
+    GLITCHEDHTTPS_TLS_PROFILE_AUTO = 3
+};
+
+/**
+ * Checks whether mbedtls encrypts with AES in hardware on this machine: that is if it was built with AES-NI support (<code>MBEDTLS_AESNI_C</code>) and the CPU has the AES-NI instructions. <p>
+ * Other hardware AES implementations (e.g. the ARMv8 crypto extensions) don't count here, because mbedtls 2 doesn't make use of them.
+ * @return <code>1</code> if AES is hardware accelerated; <code>0</code> if not.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_tls_has_aes_acceleration();
+
+/**
+ * Resolves {@link #GLITCHEDHTTPS_TLS_PROFILE_AUTO} into the profile that suits this machine (every other profile is returned as it is).
+ * @param profile The profile to resolve.
+ * @return The resolved profile.
+ */
+GLITCHEDHTTPS_API enum glitchedhttps_tls_profile glitchedhttps_tls_profile_resolve(enum glitchedhttps_tls_profile profile);
+
+/**
+ * Gets the name of a TLS profile (e.g. "throughput").
+ * @param profile The profile.
+ * @return The profile's name (a static string), or <code>"unknown"</code> if \p profile isn't a valid profile.
+ */
+GLITCHEDHTTPS_API const char* glitchedhttps_tls_profile_name(enum glitchedhttps_tls_profile profile);
+
+struct mbedtls_ssl_config;
+
+/**
+ * @private
+ * Configures the preferred cipher suites and curves of a profile (resolving {@link #GLITCHEDHTTPS_TLS_PROFILE_AUTO}) on an mbedtls SSL config.
+ * Anything that the linked mbedtls doesn't support is left out.
+ * @param ssl_config The mbedtls SSL config. The lists that get configured on it are static: only one config at a time can use this.
+ * @param profile The TLS profile.
+ * @return The resolved profile that was applied.
+ */
+GLITCHEDHTTPS_API enum glitchedhttps_tls_profile glitchedhttps_tls_profile_apply(struct mbedtls_ssl_config* ssl_config, enum glitchedhttps_tls_profile profile);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_TLS_PROFILE_H
@@ -0,0 +1,70 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_truststore.h
+ *  @brief Lazily parsed trust store: the embedded CA root certificates are indexed by subject name, and a root is only parsed when a certificate chain that's being verified needs it. Mostly for internal use!
+ */
+
+#ifndef GLITCHEDHTTPS_TRUSTSTORE_H
+#define GLITCHEDHTTPS_TRUSTSTORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include <stddef.h>
+
+struct mbedtls_x509_crt;
+
+/**
+ * @private
+ * Indexes the embedded DER CA certificates (see glitchedhttps_get_ca_certs_der()) by their subject names. Nothing is parsed yet apart from the few ASN.1 headers that lead to each subject.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> if the trust store is ready to be used; <code>GLITCHEDHTTPS_INVALID_ARG</code> if there are no embedded DER certificates
+ * (or custom CA certificates were set) and the regular chain of parsed CA certificates needs to be used instead; <code>GLITCHEDHTTPS_OUT_OF_MEM</code> if allocating the index failed.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_truststore_init();
+
+/**
+ * @private
+ * Gets the amount of root certificates in the trust store's index.
+ * @return The amount of indexed root certificates (zero if the trust store isn't initialized).
+ */
+GLITCHEDHTTPS_API size_t glitchedhttps_truststore_count();
+
+/**
+ * @private
+ * Trusted CA callback for mbedtls (an <code>mbedtls_x509_crt_ca_cb_t</code>, see <code>mbedtls_ssl_conf_ca_cb()</code>): looks up the roots whose subject is the \p child certificate's issuer
+ * and parses them (straight out of the embedded DER blob, without copying it) into a freshly allocated chain of candidates that mbedtls takes ownership of.
+ * @param ctx Unused.
+ * @param child The certificate whose issuer to look for.
+ * @param candidates Where to write the chain of candidate issuers to (<code>NULL</code> if there are none).
+ * @return <code>0</code> on success (also if there are no candidates); <code>MBEDTLS_ERR_X509_ALLOC_FAILED</code> if out of memory.
+ */
+GLITCHEDHTTPS_API int glitchedhttps_truststore_ca_cb(void* ctx, const struct mbedtls_x509_crt* child, struct mbedtls_x509_crt** candidates);
+
+/**
+ * @private
+ * Frees the trust store's index.
+ */
+GLITCHEDHTTPS_API void glitchedhttps_truststore_free();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_TRUSTSTORE_H
@@ -0,0 +1,90 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/**
+ *  @file glitchedhttps_url.h
+ *  @brief Single-pass parser that splits an http(s) URL into views of its components (nothing is copied).
+ */
+
+#ifndef GLITCHEDHTTPS_URL_H
+#define GLITCHEDHTTPS_URL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_api.h"
+#include <stddef.h>
+
+/**
+ * @brief The components of a parsed http(s) URL. <p>
+ * All of the strings are views into the parsed URL string (they're <strong>not</strong> NUL-terminated and only valid as long as the URL string is).
+ */
+struct glitchedhttps_url
+{
+    /** Whether the scheme is <code>https</code> (<code>1</code>) or <code>http</code> (<code>0</code>). */
+    int https;
+
+    /** The scheme (e.g. "https"), without the "://". */
+    const char* scheme;
+
+    /** Length of the {@link #scheme}. */
+    size_t scheme_length;
+
+    /** The host name or IP address. IPv6 addresses are given without their [square brackets]. */
+    const char* host;
+
+    /** Length of the {@link #host}. */
+    size_t host_length;
+
+    /** The host and (if there's one in the URL) port, exactly as in the URL (including the brackets of IPv6 addresses but without any user info): that's what goes into the <code>Host</code> header. */
+    const char* authority;
+
+    /** Length of the {@link #authority}. */
+    size_t authority_length;
+
+    /** The port number: either the one from the URL, or the scheme's default port (80 or 443). */
+    int port;
+
+    /** The path, starting with its '/' (but without the query or fragment). Empty (zero length) if the URL has no path. */
+    const char* path;
+
+    /** Length of the {@link #path}. */
+    size_t path_length;
+
+    /** The query string without the leading '?' (and without the fragment). <code>NULL</code> if the URL has no query. */
+    const char* query;
+
+    /** Length of the {@link #query}. */
+    size_t query_length;
+};
+
+/**
+ * Parses an http(s) URL in one pass: <code>scheme://[userinfo@]host[:port][/path][?query][#fragment]</code> <p>
+ * The scheme is matched case-insensitively; IPv6 hosts need to be in [square brackets]; user info and fragments are skipped.
+ * @param url The URL to parse. Doesn't need to be NUL-terminated.
+ * @param url_length The length of the \p url string. If this is zero, <code>strlen(url)</code> is used.
+ * @param out Where to write the URL's components into.
+ * @return <code>GLITCHEDHTTPS_SUCCESS</code> if the URL was parsed successfully; <code>GLITCHEDHTTPS_NULL_ARG</code> if \p url or \p out is <code>NULL</code>;
+ * <code>GLITCHEDHTTPS_INVALID_PORT_NUMBER</code> if the port isn't a number between 1 and 65535; <code>GLITCHEDHTTPS_INVALID_ARG</code> if the URL is malformed in any other way (e.g. unsupported scheme, empty host, unterminated IPv6 address).
+ */
+GLITCHEDHTTPS_API int glitchedhttps_url_parse(const char* url, size_t url_length, struct glitchedhttps_url* out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_URL_H
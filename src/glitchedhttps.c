@@ -18,7 +18,12 @@
 extern "C" {
 #endif
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #ifdef _WIN32
+#include <io.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #ifdef __MINGW32__
@@ -27,10 +32,13 @@ extern "C" {
 #else
 #define closesocket close
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #endif
@@ -45,6 +53,7 @@ void clear_win_sock()
 
 #include <time.h>
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "chillbuff.h"
@@ -54,26 +63,124 @@ void clear_win_sock()
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/platform.h>
 #include <mbedtls/error.h>
+#include <mbedtls/version.h>
+#include <mbedtls/ssl_ciphersuites.h>
+#include <mbedtls/oid.h>
+#include <mbedtls/pk.h>
 
 #include "glitchedhttps.h"
 #include "glitchedhttps_cacerts.h"
+#include "glitchedhttps_truststore.h"
 #include "glitchedhttps_strutil.h"
 #include "glitchedhttps_debug.h"
 #include "glitchedhttps_guid.h"
+#include "glitchedhttps_chunked.h"
+#include "glitchedhttps_decoder.h"
+#include "glitchedhttps_encoder.h"
+#include "glitchedhttps_url.h"
 
 static const char header_delimiter[] = "\r\n";
 static const size_t header_delimiter_length = 2;
 
-static const char content_delimiter[] = "\r\n\r\n";
-static const size_t content_delimiter_length = 4;
+static const char crlf[] = "\r\n";
+static const size_t crlf_length = 2;
 
 static int initialized = 0;
 static mbedtls_x509_crt cacert;
 static mbedtls_ssl_config ssl_config;
+static enum glitchedhttps_tls_profile tls_profile = GLITCHEDHTTPS_DEFAULT_TLS_PROFILE;
+static int lazy_ca_certs = 0;
 
-#define GLITCHEDHTTPS_DEFAULT_CHUNK_BUFFERSIZE 1024
 #define GLITCHEDHTTPS_MAX(x, y) (((x) > (y)) ? (x) : (y))
 
+#ifndef GLITCHEDHTTPS_MAX_RECEIVE_BUFFER_PRESIZE
+/**
+ * Upper limit (in bytes) for pre-sizing the response receive buffer from a Content-Length header value: a server's claim is not trusted
+ * beyond this (if the body really is bigger, the buffer just keeps growing in the usual way).
+ */
+#define GLITCHEDHTTPS_MAX_RECEIVE_BUFFER_PRESIZE (256 * 1024 * 1024)
+#endif
+
+/**
+ * @private
+ * Loads the trusted CA root certificates: out of the directory that was set using glitchedhttps_set_ca_certs_dir() (if any),
+ * or straight from the DER blob that's embedded at build time if there is one, otherwise by parsing the PEM bundle (or the custom CA certs that were set using glitchedhttps_set_custom_ca_certs()).
+ */
+static int load_ca_certs()
+{
+    const char* ca_certs_dir = glitchedhttps_get_ca_certs_dir();
+
+    if (ca_certs_dir != NULL)
+    {
+        /* Just like with the bundle, a positive return value is the amount of files that couldn't be parsed. */
+        const int ret = mbedtls_x509_crt_parse_path(&cacert, ca_certs_dir);
+        if (ret < 0)
+        {
+            char error_msg[256];
+            snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_x509_crt_parse_path\" returned -0x%x", -ret);
+            glitchedhttps_log_error(error_msg, __func__);
+            return ret;
+        }
+        return 0;
+    }
+
+    size_t der_count = 0;
+    const size_t* der_lengths = NULL;
+    const unsigned char* der = glitchedhttps_get_ca_certs_der(&der_lengths, &der_count);
+
+    if (der == NULL)
+    {
+        const unsigned char* ca = (const unsigned char*)glitchedhttps_get_ca_certs();
+        const size_t calen = glitchedhttps_get_ca_certs_length();
+
+        /* A positive return value is the amount of certificates that couldn't be parsed: those are skipped. */
+        const int ret = mbedtls_x509_crt_parse(&cacert, ca, calen);
+        if (ret < 0)
+        {
+            char error_msg[256];
+            snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_x509_crt_parse\" returned -0x%x", -ret);
+            glitchedhttps_log_error(error_msg, __func__);
+            return ret;
+        }
+        return 0;
+    }
+
+    for (size_t i = 0; i < der_count; der += der_lengths[i++])
+    {
+#if MBEDTLS_VERSION_NUMBER >= 0x020E0000
+        /* The blob is a static array that outlives the certificate chain: no need to copy it. */
+        const int ret = mbedtls_x509_crt_parse_der_nocopy(&cacert, der, der_lengths[i]);
+#else
+        const int ret = mbedtls_x509_crt_parse_der(&cacert, der, der_lengths[i]);
+#endif
+        /* Just like with the PEM bundle, roots that this mbedtls build can't handle are skipped. */
+        if (ret == MBEDTLS_ERR_X509_ALLOC_FAILED)
+        {
+            glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @private
+ * With the verified chain cache, mbedtls doesn't verify the server's certificate chain during the handshake (verify_server_chain() does that right after it).
+ * The shared SSL config is switched over whenever the cache gets enabled or disabled instead of on every request.
+ */
+static void apply_chaincache_authmode()
+{
+    if (glitchedhttps_chaincache_enabled())
+    {
+        mbedtls_ssl_conf_authmode(&ssl_config, MBEDTLS_SSL_VERIFY_NONE);
+    }
+    else
+    {
+        mbedtls_ssl_conf_authmode(&ssl_config, MBEDTLS_SSL_VERIFY_REQUIRED);
+    }
+}
+
 int glitchedhttps_init()
 {
     if (initialized)
@@ -84,15 +191,17 @@ int glitchedhttps_init()
     mbedtls_x509_crt_init(&cacert);
     mbedtls_ssl_config_init(&ssl_config);
 
-    const unsigned char* ca = (const unsigned char*)glitchedhttps_get_ca_certs();
-    const size_t calen = glitchedhttps_get_ca_certs_length();
+    int ret = 0;
+    lazy_ca_certs = 0;
+
+#if defined(GLITCHEDHTTPS_LAZY_CA_CERTS) && defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    /* Only index the embedded roots (or look nothing up at all, with a CA certs directory) for now: each root is parsed when a certificate chain needs it (see glitchedhttps_truststore_ca_cb()). */
+    lazy_ca_certs = glitchedhttps_truststore_init() == GLITCHEDHTTPS_SUCCESS;
+#endif
 
-    int ret = mbedtls_x509_crt_parse(&cacert, ca, calen);
-    if (ret < 0)
+    if (!lazy_ca_certs && (ret = load_ca_certs()) != 0)
     {
-        char error_msg[256];
-        snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_x509_crt_parse\" returned -0x%x", -ret);
-        glitchedhttps_log_error(error_msg, __func__);
+        mbedtls_x509_crt_free(&cacert);
         return ret;
     }
 
@@ -103,11 +212,24 @@ int glitchedhttps_init()
         snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_ssl_config_defaults\" returned %d", ret);
         glitchedhttps_log_error(error_msg, __func__);
         mbedtls_x509_crt_free(&cacert);
+        glitchedhttps_truststore_free();
         return ret;
     }
 
-    mbedtls_ssl_conf_ca_chain(&ssl_config, &cacert, NULL);
+#if defined(GLITCHEDHTTPS_LAZY_CA_CERTS) && defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    if (lazy_ca_certs)
+    {
+        mbedtls_ssl_conf_ca_cb(&ssl_config, &glitchedhttps_truststore_ca_cb, NULL);
+    }
+    else
+#endif
+    {
+        mbedtls_ssl_conf_ca_chain(&ssl_config, &cacert, NULL);
+    }
+
     mbedtls_ssl_conf_dbg(&ssl_config, &glitchedhttps_debug, stdout);
+    glitchedhttps_tls_profile_apply(&ssl_config, tls_profile);
+    apply_chaincache_authmode();
 
     initialized = 1;
     return 0;
@@ -116,26 +238,171 @@ int glitchedhttps_init()
 void glitchedhttps_free()
 {
     mbedtls_x509_crt_free(&cacert);
+    glitchedhttps_truststore_free();
+    glitchedhttps_chaincache_clear();
     mbedtls_ssl_config_free(&ssl_config);
+    lazy_ca_certs = 0;
     initialized = 0;
 }
 
+int glitchedhttps_set_tls_profile(const enum glitchedhttps_tls_profile profile)
+{
+    if (profile < GLITCHEDHTTPS_TLS_PROFILE_COMPAT || profile > GLITCHEDHTTPS_TLS_PROFILE_AUTO)
+    {
+        glitchedhttps_log_error("Invalid TLS profile!", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    tls_profile = profile;
+
+    if (initialized)
+    {
+        glitchedhttps_tls_profile_apply(&ssl_config, tls_profile);
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+void glitchedhttps_set_verified_chain_cache_ttl(const uint32_t seconds)
+{
+    glitchedhttps_chaincache_set_ttl(seconds);
+
+    if (initialized)
+    {
+        apply_chaincache_authmode();
+    }
+}
+
+enum glitchedhttps_tls_profile glitchedhttps_get_tls_profile()
+{
+    return glitchedhttps_tls_profile_resolve(tls_profile);
+}
+
 /** @private */
-static int parse_response_string(const chillbuff* response_string, struct glitchedhttps_response** out)
+static const char* find_delimiter(const char* begin, const char* end, const char* delimiter, const size_t delimiter_length)
 {
-    if (response_string == NULL)
+    while (begin + delimiter_length <= end)
     {
-        glitchedhttps_log_error("HTTP response parse error: \"response_string\" argument NULL; nothing to parse!", __func__);
-        return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+        const char* c = memchr(begin, delimiter[0], (end - begin) - delimiter_length + 1);
+        if (c == NULL)
+        {
+            return NULL;
+        }
+
+        if (memcmp(c, delimiter, delimiter_length) == 0)
+        {
+            return c;
+        }
+
+        begin = c + 1;
+    }
+
+    return NULL;
+}
+
+/** @private */
+static char* copy_string(const char* string, const size_t length)
+{
+    char* out = malloc((length + 1) * sizeof(char));
+    if (out == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(out, string, length);
+    out[length] = '\0';
+    return out;
+}
+
+/**
+ * @private
+ * Gets a buffer of at least \p size bytes: the \p retained one (left over from the last time a reused response was filled) if it's big enough, or a newly allocated one.
+ * @param retained The retained buffer (or <code>NULL</code>). The caller must forget about it after this call: it's either returned or freed.
+ * @param capacity The size of the \p retained buffer. Set to the size of the returned buffer.
+ * @param size The minimum amount of bytes needed.
+ * @return The buffer, or <code>NULL</code> if allocating it failed.
+ */
+static void* take_buffer(void* retained, size_t* capacity, const size_t size)
+{
+    if (retained != NULL && *capacity >= size)
+    {
+        return retained;
+    }
+
+    free(retained);
+
+    void* buffer = malloc(size);
+    *capacity = buffer != NULL ? size : 0;
+    return buffer;
+}
+
+/**
+ * @private
+ * Initializes a chillbuff on top of a \p retained array (if there is one), instead of allocating a new one.
+ */
+static int init_chillbuff(chillbuff* buffer, void* retained, const size_t retained_capacity, const size_t initial_capacity, const size_t element_size)
+{
+    if (retained == NULL || retained_capacity == 0)
+    {
+        free(retained);
+        return chillbuff_init(buffer, initial_capacity, element_size, CHILLBUFF_GROW_DUPLICATIVE) == CHILLBUFF_SUCCESS ? GLITCHEDHTTPS_SUCCESS : GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    buffer->array = retained;
+    buffer->length = 0;
+    buffer->capacity = retained_capacity;
+    buffer->element_size = element_size;
+    buffer->growth_method = CHILLBUFF_GROW_DUPLICATIVE;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int push_header(chillbuff* header_builder, const char* type, const size_t type_length, const char* value, const size_t value_length)
+{
+    struct glitchedhttps_header* header = glitchedhttps_header_init(type, type_length, value, value_length);
+    if (header == NULL)
+    {
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    /* The builder takes over ownership of the two header strings: only the outer struct is freed here. */
+    if (chillbuff_push_back(header_builder, header, 1) != CHILLBUFF_SUCCESS)
+    {
+        glitchedhttps_header_free(header);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    free(header);
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int push_chunked_header(void* header_builder, const char* type, const size_t type_length, const char* value, const size_t value_length)
+{
+    return push_header((chillbuff*)header_builder, type, type_length, value, value_length);
+}
+
+/** @private */
+static void free_header_builder(chillbuff* header_builder)
+{
+    for (size_t i = 0; i < header_builder->length; ++i)
+    {
+        struct glitchedhttps_header* h = &((struct glitchedhttps_header*)header_builder->array)[i];
+        free(h->type);
+        free(h->value);
     }
+    chillbuff_free(header_builder);
+}
 
+/** @private */
+static struct glitchedhttps_response* new_response()
+{
     /* Allocate the output http response struct and set pointers to default value "NULL".
-     * The consumer of this returned value should not forget to call  on this! */
+     * The consumer of this returned value should not forget to call glitchedhttps_response_free() on this! */
     struct glitchedhttps_response* response = malloc(sizeof(struct glitchedhttps_response));
     if (response == NULL)
     {
-        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
-        return GLITCHEDHTTPS_OUT_OF_MEM;
+        return NULL;
     }
 
     response->raw = NULL;
@@ -147,244 +414,1978 @@ static int parse_response_string(const chillbuff* response_string, struct glitch
     response->content_encoding = NULL;
     response->content_length = 0;
     response->headers_count = 0;
+    response->header_index = NULL;
+    response->header_lines = NULL;
+    response->header_lines_count = 0;
     response->status_code = -1;
 
-    response->raw = malloc((response_string->length + 1) * response_string->element_size);
-    if (response->raw == NULL)
-    {
-        glitchedhttps_response_free(response);
-        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
-        return GLITCHEDHTTPS_OUT_OF_MEM;
-    }
+    memset(&response->buffers, 0x00, sizeof(struct glitchedhttps_response_buffers));
 
-    /* First of all, copy the whole, raw response string into the output. */
-    memcpy(response->raw, response_string->array, response_string->length);
-    response->raw[response_string->length] = '\0';
+    return response;
+}
 
-    /* Next comes the tedious parsing. */
+/** @private */
+struct response_head
+{
+    /** Where the content body starts (right after the empty line that ends the header section); <code>NULL</code> if the header section is incomplete. */
+    char* content;
+
+    /** Whether the response body uses chunked transfer encoding. */
+    int chunked;
+
+    /** Whether the response contained a Content-Length header. */
+    int content_length_known;
+};
+
+/**
+ * @private
+ * Parses the status code out of an HTTP response's status line (e.g. <code>"HTTP/1.1 200 OK"</code>).
+ * @return The status code, or <code>-1</code> if the status line is malformed.
+ */
+static int parse_status_code(const char* status_line, const char* status_line_end)
+{
+    const char* c = memchr(status_line, ' ', status_line_end - status_line);
+    if (c == NULL || status_line_end - c <= 3)
+    {
+        return -1;
+    }
 
-    char* current = response_string->array;
-    char* next = strstr(current, header_delimiter);
+    char n[4] = { 0x00 };
+    memcpy(n, c + 1, 3);
+    return (int)strtol(n, NULL, 10);
+}
 
-    int parsed_status = 0, parsed_server = 0, parsed_date = 0, parsed_content_type = 0, parsed_content_encoding = 0, parsed_content_length = 0, parsed_chunked_transfer = 0;
+/** @private Parses the status code out of the status line at the start of a (complete) response head. */
+static int response_head_status_code(const char* begin, const char* head_end)
+{
+    const char* status_line_end = find_delimiter(begin, head_end, header_delimiter, header_delimiter_length);
+    return parse_status_code(begin, status_line_end != NULL ? status_line_end : head_end);
+}
 
-    chillbuff header_builder;
-    if (chillbuff_init(&header_builder, 16, sizeof(struct glitchedhttps_header), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
+/**
+ * @private
+ * Checks whether the response to a request can have a body at all (or whether the caller even wants it).
+ * Responses to HEAD requests as well as 1xx, 204 (No Content) and 304 (Not Modified) responses never have one.
+ */
+static int response_has_body(const struct glitchedhttps_request* request, const int status_code)
+{
+    if (request->headers_only || request->method == GLITCHEDHTTPS_HEAD)
     {
-        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
-        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+        return 0;
     }
 
+    return !((status_code >= 100 && status_code < 200) || status_code == 204 || status_code == 304);
+}
+
+/**
+ * @private
+ * Parses the status line and the header fields of an HTTP response into the passed response and header builder. <p>
+ * If a \p line_builder is passed, the header fields aren't copied at all: only where their lines lie (relative to \p begin) is recorded into it, as glitchedhttps_header_line entries.
+ * The body framing headers are still evaluated right away, and so is the Content-Encoding (the body can't be handed out without knowing it).
+ */
+static int parse_response_head(char* begin, char* end, struct glitchedhttps_response* response, chillbuff* header_builder, chillbuff* line_builder, struct response_head* head)
+{
+    char* current = begin;
+
+    head->content = NULL;
+    head->chunked = 0;
+    head->content_length_known = 0;
+
+    int parsed_status = 0, parsed_server = 0, parsed_date = 0, parsed_content_type = 0, parsed_content_encoding = 0, parsed_content_length = 0;
+
+    char* next = (char*)find_delimiter(current, end, header_delimiter, header_delimiter_length);
+
     while (next != NULL)
     {
         const size_t current_length = next - current;
 
-        if (!parsed_status && glitchedhttps_strncmpic(current, "HTTP/", 5) == 0)
-        {
-            const char* c = memchr(current, ' ', current_length);
-            if (c != NULL)
-            {
-                char n[4] = { 0x00 };
-                memcpy(n, c + 1, 3);
-                response->status_code = strtol(n, NULL, 10);
-            }
-            parsed_status = 1;
-        }
-        else if (!parsed_server && glitchedhttps_strncmpic(current, "Server: ", 8) == 0)
-        {
-            const size_t out_length = current_length - 8;
-            response->server = malloc((out_length + 1) * sizeof(char));
-            if (response->server == NULL)
-            {
-                goto out_of_mem;
-            }
-            memcpy(response->server, current + 8, out_length);
-            response->server[out_length] = '\0';
-            chillbuff_push_back(&header_builder, glitchedhttps_header_init(current, 6, response->server, out_length), 1);
-            parsed_server = 1;
-        }
-        else if (!parsed_date && glitchedhttps_strncmpic(current, "Date: ", 6) == 0)
-        {
-            const size_t out_length = current_length - 6;
-            response->date = malloc((out_length + 1) * sizeof(char));
-            if (response->date == NULL)
-            {
-                goto out_of_mem;
-            }
-            memcpy(response->date, current + 6, out_length);
-            response->date[out_length] = '\0';
-            chillbuff_push_back(&header_builder, glitchedhttps_header_init(current, 4, response->date, out_length), 1);
-            parsed_date = 1;
-        }
-        else if (!parsed_content_type && glitchedhttps_strncmpic(current, "Content-Type: ", 14) == 0)
-        {
-            const size_t out_length = current_length - 14;
-            response->content_type = malloc((out_length + 1) * sizeof(char));
-            if (response->content_type == NULL)
-            {
-                goto out_of_mem;
-            }
-            memcpy(response->content_type, current + 14, out_length);
-            response->content_type[out_length] = '\0';
-            chillbuff_push_back(&header_builder, glitchedhttps_header_init(current, 12, response->content_type, out_length), 1);
-            parsed_content_type = 1;
-        }
-        else if (!parsed_content_encoding && glitchedhttps_strncmpic(current, "Content-Encoding: ", 18) == 0)
-        {
-            const size_t out_length = current_length - 18;
-            response->content_encoding = malloc((out_length + 1) * sizeof(char));
-            if (response->content_encoding == NULL)
-            {
-                goto out_of_mem;
-            }
-            memcpy(response->content_encoding, current + 18, out_length);
-            response->content_encoding[out_length] = '\0';
-            chillbuff_push_back(&header_builder, glitchedhttps_header_init(current, 16, response->content_encoding, out_length), 1);
-            parsed_content_encoding = 1;
-        }
-        else if (!parsed_content_length && glitchedhttps_strncmpic(current, "Content-Length: ", 16) == 0)
+        if (current_length == 0 && parsed_status) // The empty line after the headers: content body found.
         {
-            const char* c = memchr(current, ' ', current_length);
-            if (c != NULL)
-            {
-                char n[64] = { 0x00 };
-                memcpy(n, c + 1, current_length - 1);
-                response->content_length = strtol(n, NULL, 10);
-                snprintf(n, sizeof(n), "%zu", response->content_length);
-                chillbuff_push_back(&header_builder, glitchedhttps_header_init(current, 14, n, strlen(n)), 1);
-            }
-            parsed_content_length = 1;
+            head->content = next + header_delimiter_length;
+            break;
         }
-        else if (glitchedhttps_strncmpic(current, "Transfer-Encoding: chunked", 26) == 0) // Allow HTTP/1.1's chunked transfer encoding.
+
+        if (!parsed_status && current_length > 5 && glitchedhttps_strnequalic(current, "HTTP/", 5))
         {
-            chillbuff_push_back(&header_builder, glitchedhttps_header_init("Transfer-Encoding", 17, "chunked", 7), 1);
-            parsed_chunked_transfer = 1;
+            response->status_code = parse_status_code(current, next);
+            parsed_status = 1;
         }
-        else if (current != response_string->array && strncmp(current - header_delimiter_length, content_delimiter, content_delimiter_length) == 0) // content body found
+        else
         {
-            char* content = (current - header_delimiter_length) + content_delimiter_length;
-            size_t content_length = parsed_chunked_transfer ? GLITCHEDHTTPS_DEFAULT_CHUNK_BUFFERSIZE : response->content_length;
-            if (content_length > 0)
+            /* Lines without a colon or with an empty field name aren't header fields: they're dropped. */
+            const char* colon = memchr(current, ':', current_length);
+            if (colon != NULL && colon != current)
             {
-                if (parsed_chunked_transfer)
-                {
-                    chillbuff content_buffer;
-                    int r = chillbuff_init(&content_buffer, content_length, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE);
-                    if (r != CHILLBUFF_SUCCESS)
-                    {
-                        goto out_of_mem;
-                    }
+                const size_t type_length = colon - current;
 
-                    size_t chunksize;
-                    while ((chunksize = strtol(content, NULL, 16)) != 0)
-                    {
-                        content = strstr(content, header_delimiter);
-                        if (content == NULL)
+                const char* value = colon + 1;
+                while (value < next && (*value == ' ' || *value == '\t'))
+                    ++value;
+
+                size_t value_length = next - value;
+                while (value_length > 0 && (value[value_length - 1] == ' ' || value[value_length - 1] == '\t'))
+                    --value_length;
+
+                char** field = NULL;
+                const int lazy = line_builder != NULL;
+
+                switch (glitchedhttps_header_lookup(current, type_length))
+                {
+                    case GLITCHEDHTTPS_HEADER_SERVER:
+                        if (!parsed_server && !lazy)
                         {
-                            break;
+                            field = &response->server;
+                            parsed_server = 1;
                         }
-                        content += header_delimiter_length;
-                        chillbuff_push_back(&content_buffer, content, chunksize);
-                        content += chunksize + header_delimiter_length;
-                    }
-
-                    response->content = malloc(content_buffer.length + 1);
-                    if (response->content == NULL)
-                    {
-                        goto out_of_mem;
-                    }
+                        break;
+                    case GLITCHEDHTTPS_HEADER_DATE:
+                        if (!parsed_date && !lazy)
+                        {
+                            field = &response->date;
+                            parsed_date = 1;
+                        }
+                        break;
+                    case GLITCHEDHTTPS_HEADER_CONTENT_TYPE:
+                        if (!parsed_content_type && !lazy)
+                        {
+                            field = &response->content_type;
+                            parsed_content_type = 1;
+                        }
+                        break;
+                    case GLITCHEDHTTPS_HEADER_CONTENT_ENCODING:
+                        if (!parsed_content_encoding)
+                        {
+                            field = &response->content_encoding;
+                            parsed_content_encoding = 1;
+                        }
+                        break;
+                    case GLITCHEDHTTPS_HEADER_CONTENT_LENGTH:
+                        if (!parsed_content_length)
+                        {
+                            response->content_length = strtoull(value, NULL, 10);
+                            head->content_length_known = 1;
+                            parsed_content_length = 1;
+                        }
+                        break;
+                    case GLITCHEDHTTPS_HEADER_TRANSFER_ENCODING:
+                        /* Allow HTTP/1.1's chunked transfer encoding (which is always the last of the applied transfer codings). */
+                        if (value_length >= 7 && glitchedhttps_strnequalic(value + value_length - 7, "chunked", 7))
+                        {
+                            head->chunked = 1;
+                        }
+                        break;
+                    default:
+                        break;
+                }
 
-                    memcpy(response->content, content_buffer.array, content_buffer.length);
-                    response->content[content_buffer.length] = '\0';
-                    response->content_length = content_buffer.length;
-                    chillbuff_clear(&content_buffer);
+                if (field != NULL && (*field = copy_string(value, value_length)) == NULL)
+                {
+                    return GLITCHEDHTTPS_OUT_OF_MEM;
                 }
-                else
+
+                if (lazy)
                 {
-                    response->content = malloc(content_length + 1);
-                    if (response->content == NULL)
+                    const struct glitchedhttps_header_line line = { (size_t)(current - begin), current_length };
+                    if (chillbuff_push_back(line_builder, &line, 1) != CHILLBUFF_SUCCESS)
                     {
-                        goto out_of_mem;
+                        return GLITCHEDHTTPS_OUT_OF_MEM;
                     }
-                    memcpy(response->content, content, content_length);
-                    response->content[content_length] = '\0';
+                }
+                else if (push_header(header_builder, current, type_length, value, value_length) != GLITCHEDHTTPS_SUCCESS)
+                {
+                    return GLITCHEDHTTPS_OUT_OF_MEM;
                 }
             }
-            else
-            {
-                response->content = NULL;
-                response->content_length = 0;
-            }
-            break; // If the content (request body) was found, it's time to stop. Because there won't be anything else to come.
         }
-        else
-        {
-            const char header_separator[] = ": ";
-            const size_t header_separator_length = strlen(header_separator);
 
-            const char* header_value = strstr(current, header_separator);
-            if (header_value != NULL)
-            {
-                const size_t header_type_length = header_value - current;
-                const size_t header_value_length = current_length - header_type_length - header_separator_length;
-                chillbuff_push_back(&header_builder, glitchedhttps_header_init(current, header_type_length, header_value + header_separator_length, header_value_length), 1);
-            }
-        }
         current = next + header_delimiter_length;
-        next = strstr(current, header_delimiter);
+        next = (char*)find_delimiter(current, end, header_delimiter, header_delimiter_length);
     }
 
-    response->headers = malloc(sizeof(struct glitchedhttps_header) * header_builder.length);
-    if (response->headers == NULL)
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Copies the headers collected in the builder over into the response (the header strings then belong to the response) and indexes them.
+ */
+static int adopt_headers(struct glitchedhttps_response* response, chillbuff* header_builder)
+{
+    if (response->headers != header_builder->array)
     {
-        goto out_of_mem;
+        free(response->headers);
     }
 
-    /* Copy the response headers into the output instance. */
-    response->headers_count = header_builder.length;
-    for (size_t i = 0; i < header_builder.length; i++)
+    /* The builder's array becomes the response's header array (its spare capacity is useful if the response gets reused). */
+    response->headers = header_builder->array;
+    response->headers_count = header_builder->length;
+    response->buffers.headers_capacity = header_builder->capacity;
+
+    header_builder->array = NULL;
+    chillbuff_free(header_builder);
+
+    if (glitchedhttps_response_index_headers(response) != GLITCHEDHTTPS_SUCCESS)
     {
-        const struct glitchedhttps_header h = ((struct glitchedhttps_header*)header_builder.array)[i];
-        response->headers[i] = *glitchedhttps_header_init(h.type, strlen(h.type), h.value, strlen(h.value));
+        glitchedhttps_log_error("Couldn't allocate the response header index: header lookups will fall back to a linear scan.", __func__);
     }
 
-    *out = response;
-    chillbuff_free(&header_builder);
     return GLITCHEDHTTPS_SUCCESS;
-
-out_of_mem:
-    glitchedhttps_log_error("OUT OF MEMORY!", __func__);
-    glitchedhttps_response_free(response);
-    chillbuff_free(&header_builder);
-    return GLITCHEDHTTPS_OUT_OF_MEM;
 }
 
-/** @private */
-static int https_request(const char* server_name, const int server_port, const char* request, const size_t buffer_size, const int ssl_verification_optional, struct glitchedhttps_response** out)
+/**
+ * @private
+ * Frees a response that's still under construction together with its header builder. <p>
+ * If the response is the \p target that the caller wanted to have refilled, it's only reset instead.
+ */
+static void discard_response(struct glitchedhttps_response* response, chillbuff* header_builder, struct glitchedhttps_response* target)
 {
-    if (server_name == NULL || request == NULL || server_port <= 0)
+    if (response != NULL && response->headers == header_builder->array)
     {
-        glitchedhttps_log_error("INVALID HTTPS parameters passed into \"https_request\". Returning NULL...", __func__);
-        return GLITCHEDHTTPS_INVALID_ARG;
+        /* The headers are still owned by the builder. */
+        response->headers = NULL;
+        response->headers_count = 0;
     }
 
-    chillbuff response_string;
-
-    if (chillbuff_init(&response_string, 1024, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
+    if (response != NULL && response == target)
     {
-        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
-        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+        glitchedhttps_response_reset(response);
+    }
+    else
+    {
+        glitchedhttps_response_free(response);
     }
 
-    uint32_t flags;
-    int ret = 1, exit_code = -1;
-    int mbedtls_exit_code = MBEDTLS_EXIT_FAILURE;
+    free_header_builder(header_builder);
+}
 
-    char error_msg[256] = { 0x00 };
+/**
+ * @private
+ * Checks whether the response body needs to be decoded, and if so, sets up the passed decoding pipeline for it (according to the response's Content-Encoding).
+ * @return Whether the response body is going to be decoded.
+ */
+static int init_decoding(const struct glitchedhttps_request* request, struct glitchedhttps_response* response, struct glitchedhttps_decoding_pipeline* pipeline, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    pipeline->count = 0;
 
-    unsigned char buffer_stack[GLITCHEDHTTPS_STACK_BUFFERSIZE];
-    unsigned char* buffer_heap = NULL;
-    if (buffer_size > sizeof(buffer_stack))
+    if (!request->decompress_response || response->content_encoding == NULL)
+    {
+        return 0;
+    }
+
+    /* If any of the content codings isn't supported, the body is passed on as it is (still encoded). */
+    if (glitchedhttps_decoding_pipeline_init(pipeline, response->content_encoding, strlen(response->content_encoding), output, output_ctx) != GLITCHEDHTTPS_SUCCESS)
+    {
+        return 0;
+    }
+
+    /* The body handed out to the caller won't be encoded anymore (the original header is still in the header list). */
+    free(response->content_encoding);
+    response->content_encoding = NULL;
+    return pipeline->count > 0;
+}
+
+/** @private */
+static int push_decompressed(void* content_builder, const char* data, const size_t length)
+{
+    return chillbuff_push_back((chillbuff*)content_builder, data, length) == CHILLBUFF_SUCCESS ? GLITCHEDHTTPS_SUCCESS : GLITCHEDHTTPS_OUT_OF_MEM;
+}
+
+/**
+ * @private
+ * Sets the response body: a plain copy of it, or - if it's compressed and the request asked for it - its decompressed version (which is inflated straight into the response content).
+ */
+static int set_content(const struct glitchedhttps_request* request, struct glitchedhttps_response* response, const char* content, const size_t content_length)
+{
+    chillbuff decompressed;
+    struct glitchedhttps_decoding_pipeline pipeline;
+
+    struct glitchedhttps_response_buffers* buffers = &response->buffers;
+
+    if (!init_decoding(request, response, &pipeline, &push_decompressed, &decompressed))
+    {
+        response->content = take_buffer(buffers->content, &buffers->content_capacity, content_length + 1);
+        buffers->content = NULL;
+
+        if (response->content == NULL)
+        {
+            glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+            return GLITCHEDHTTPS_OUT_OF_MEM;
+        }
+
+        memcpy(response->content, content, content_length);
+        response->content[content_length] = '\0';
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    const int r_init = init_chillbuff(&decompressed, buffers->content, buffers->content_capacity, GLITCHEDHTTPS_MAX(content_length * 4, 1024), sizeof(char));
+    buffers->content = NULL;
+
+    if (r_init != GLITCHEDHTTPS_SUCCESS)
+    {
+        glitchedhttps_decoding_pipeline_free(&pipeline);
+        return r_init;
+    }
+
+    int r = glitchedhttps_decoding_pipeline_update(&pipeline, content, content_length);
+
+    if (r == GLITCHEDHTTPS_SUCCESS)
+    {
+        r = glitchedhttps_decoding_pipeline_finish(&pipeline);
+    }
+
+    glitchedhttps_decoding_pipeline_free(&pipeline);
+
+    if (r == GLITCHEDHTTPS_SUCCESS)
+    {
+        r = push_decompressed(&decompressed, "", 1);
+    }
+
+    if (r != GLITCHEDHTTPS_SUCCESS)
+    {
+        chillbuff_free(&decompressed);
+        return r;
+    }
+
+    /* The builder's array (NUL-terminated) becomes the response content. */
+    response->content = decompressed.array;
+    response->content_length = decompressed.length - 1;
+    buffers->content_capacity = decompressed.capacity;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Parses a whole, buffered response into \p out. If <code>*out</code> isn't <code>NULL</code>, that (reset) response is refilled instead of allocating a new one.
+ */
+static int parse_response_string(chillbuff* response_string, const struct glitchedhttps_request* request, struct glitchedhttps_response** out)
+{
+    if (response_string == NULL)
+    {
+        glitchedhttps_log_error("HTTP response parse error: \"response_string\" argument NULL; nothing to parse!", __func__);
+        return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+    }
+
+    struct glitchedhttps_response* const target = *out;
+
+    struct glitchedhttps_response* response = target != NULL ? target : new_response();
+    if (response == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    struct glitchedhttps_response_buffers* buffers = &response->buffers;
+
+    chillbuff header_builder;
+    if (init_chillbuff(&header_builder, buffers->headers, buffers->headers_capacity, 16, sizeof(struct glitchedhttps_header)) != GLITCHEDHTTPS_SUCCESS)
+    {
+        buffers->headers = NULL;
+        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
+        if (response != target)
+            glitchedhttps_response_free(response);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    buffers->headers = NULL;
+
+    response->raw = take_buffer(buffers->raw, &buffers->raw_capacity, response_string->length + 1);
+    buffers->raw = NULL;
+
+    if (response->raw == NULL)
+    {
+        goto out_of_mem;
+    }
+
+    /* First of all, copy the whole, raw response string into the output. */
+    memcpy(response->raw, response_string->array, response_string->length);
+    response->raw[response_string->length] = '\0';
+
+    /* Next comes the tedious parsing. */
+
+    chillbuff line_builder;
+    if (request->lazy_headers)
+    {
+        const int r = init_chillbuff(&line_builder, buffers->header_lines, buffers->header_lines_capacity, 16, sizeof(struct glitchedhttps_header_line));
+        buffers->header_lines = NULL;
+
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
+            discard_response(response, &header_builder, target);
+            return r;
+        }
+    }
+
+    char* const end = (char*)response_string->array + response_string->length;
+
+    struct response_head head;
+    const int parsed = parse_response_head(response_string->array, end, response, &header_builder, request->lazy_headers ? &line_builder : NULL, &head);
+
+    if (request->lazy_headers)
+    {
+        /* The recorded line offsets are valid for the raw response string too (it's an exact copy of the parsed buffer). */
+        if (line_builder.length > 0)
+        {
+            response->header_lines = line_builder.array;
+            response->header_lines_count = line_builder.length;
+        }
+        else
+        {
+            /* Keep the (empty) array around for the next time the response is refilled. */
+            buffers->header_lines = line_builder.array;
+        }
+        buffers->header_lines_capacity = line_builder.capacity;
+    }
+
+    if (parsed != GLITCHEDHTTPS_SUCCESS)
+    {
+        goto out_of_mem;
+    }
+
+    char* content = head.content;
+
+    if (content != NULL && response_has_body(request, response->status_code))
+    {
+        if (head.chunked)
+        {
+            /* Decode the chunks in place (inside the receive buffer) and then copy the body out only once. */
+            struct glitchedhttps_chunked_decoder decoder;
+            glitchedhttps_chunked_decoder_init(&decoder, &push_chunked_header, &header_builder);
+
+            size_t decoded_length = 0;
+            const int r = glitchedhttps_chunked_decode(&decoder, content, end - content, &decoded_length);
+            if (r != GLITCHEDHTTPS_SUCCESS)
+            {
+                glitchedhttps_log_error("HTTP response parse error: invalid chunked transfer encoding!", __func__);
+                discard_response(response, &header_builder, target);
+                return r == GLITCHEDHTTPS_OUT_OF_MEM ? r : GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+            }
+
+            /* The connection was closed before the last chunk (and the trailer section) arrived: the body is incomplete. */
+            if (!glitchedhttps_chunked_decoder_done(&decoder))
+            {
+                glitchedhttps_log_error("HTTP response parse error: the connection was closed in the middle of the chunked response body!", __func__);
+                discard_response(response, &header_builder, target);
+                return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+            }
+
+            response->content_length = decoded_length;
+        }
+        else if (response->content_length > (size_t)(end - content))
+        {
+            /* Fewer body bytes arrived than the Content-Length header announced. */
+            glitchedhttps_log_error("HTTP response parse error: the connection was closed before the whole response body (as announced by the Content-Length header) was received!", __func__);
+            discard_response(response, &header_builder, target);
+            return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+        }
+
+        if (response->content_length > 0)
+        {
+            const int r = set_content(request, response, content, response->content_length);
+            if (r != GLITCHEDHTTPS_SUCCESS)
+            {
+                discard_response(response, &header_builder, target);
+                return r;
+            }
+        }
+    }
+
+    if (response->content == NULL)
+    {
+        response->content_length = 0;
+    }
+
+    if (adopt_headers(response, &header_builder) != GLITCHEDHTTPS_SUCCESS)
+    {
+        goto out_of_mem;
+    }
+
+    *out = response;
+    return GLITCHEDHTTPS_SUCCESS;
+
+out_of_mem:
+    glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+    discard_response(response, &header_builder, target);
+    return GLITCHEDHTTPS_OUT_OF_MEM;
+}
+
+/**
+ * @private
+ * Collects a response as it's being received: either the whole thing (to be parsed once the connection closes),
+ * or - if the request has an glitchedhttps_request::on_body callback or glitchedhttps_request::output_fd - just the response head, after which the body bytes are passed on as they arrive.
+ */
+struct response_reader
+{
+    /** The request whose response is being read. */
+    const struct glitchedhttps_request* request;
+
+    /** The whole raw response, or only the response head when streaming the body. */
+    chillbuff buffer;
+
+    /** [Streaming only] Collects the response headers (plus any chunked trailers). */
+    chillbuff header_builder;
+
+    /** [Streaming only] The response, allocated (or taken from {@link #target}) once its head is complete. */
+    struct glitchedhttps_response* response;
+
+    /** [OPTIONAL] A reset response to refill instead of allocating a new one (its retained buffers are reused). */
+    struct glitchedhttps_response* target;
+
+    /** [Streaming only] Decoder state for chunked response bodies. */
+    struct glitchedhttps_chunked_decoder chunked_decoder;
+
+    /** [Streaming only] Decoders for compressed response bodies (its stage count is <code>0</code> if the body is passed on as it is). */
+    struct glitchedhttps_decoding_pipeline decoding;
+
+    /** [Streaming only] Body framing information from the response head. */
+    struct response_head head;
+
+    /** [Streaming only] How many body bytes are still expected (if the response contained a Content-Length header). */
+    size_t body_remaining;
+
+    /** Total amount of bytes received so far. */
+    size_t received;
+
+    /** Whether the response body is passed on as it arrives (to glitchedhttps_request::on_body or glitchedhttps_request::output_fd) instead of being buffered. */
+    int streaming;
+
+    /** [Linux only] Set if <code>splice()</code> turned out not to work for the given output file descriptor. */
+    int splice_unsupported;
+
+    /** [Linux only] Set once <code>splice()</code> hit the end of the stream (the server closed the connection), whether or not the body was complete. */
+    int splice_eof;
+
+    /** [Buffering only] Set once the response head was found in the buffer (and the buffer was pre-sized from its Content-Length header, if there was one). */
+    int head_scanned;
+
+    /** [Buffering only] The total response size (head + Content-Length), if known. Once the buffer holds this many bytes, the response is complete. */
+    size_t expected_length;
+
+    /** Set once the response is known to be complete (no need to wait for the server to close the connection). */
+    int done;
+
+    /** Set once a <code>100 Continue</code> interim response was received (and skipped). */
+    int continue_received;
+};
+
+/** @private */
+static int response_reader_init(struct response_reader* reader, const struct glitchedhttps_request* request, struct glitchedhttps_response* target)
+{
+    memset(reader, 0x00, sizeof(struct response_reader));
+    reader->request = request;
+    reader->target = target;
+    reader->streaming = request->on_body != NULL || request->output_fd > 0;
+
+    char* retained_buffer = NULL;
+    size_t retained_buffer_capacity = 0;
+    struct glitchedhttps_header* retained_headers = NULL;
+    size_t retained_headers_capacity = 0;
+
+    if (target != NULL)
+    {
+        retained_buffer = target->buffers.receive_buffer;
+        retained_buffer_capacity = target->buffers.receive_buffer_capacity;
+        target->buffers.receive_buffer = NULL;
+
+        if (reader->streaming)
+        {
+            retained_headers = target->buffers.headers;
+            retained_headers_capacity = target->buffers.headers_capacity;
+            target->buffers.headers = NULL;
+        }
+    }
+
+    if (init_chillbuff(&reader->buffer, retained_buffer, retained_buffer_capacity, 1024, sizeof(char)) != GLITCHEDHTTPS_SUCCESS)
+    {
+        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
+        free(retained_headers);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    if (reader->streaming && init_chillbuff(&reader->header_builder, retained_headers, retained_headers_capacity, 16, sizeof(struct glitchedhttps_header)) != GLITCHEDHTTPS_SUCCESS)
+    {
+        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
+        chillbuff_free(&reader->buffer);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static void response_reader_free(struct response_reader* reader)
+{
+    if (reader->streaming)
+    {
+        discard_response(reader->response, &reader->header_builder, reader->target);
+        reader->response = NULL;
+        glitchedhttps_decoding_pipeline_free(&reader->decoding);
+    }
+
+    if (reader->target != NULL)
+    {
+        /* Hand the receive buffer back to the reused response for next time. */
+        free(reader->target->buffers.receive_buffer);
+        reader->target->buffers.receive_buffer = reader->buffer.array;
+        reader->target->buffers.receive_buffer_capacity = reader->buffer.capacity;
+        reader->buffer.array = NULL;
+    }
+
+    chillbuff_free(&reader->buffer);
+}
+
+/** @private */
+static int write_to_fd(const int fd, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+#ifdef _WIN32
+        const int n = _write(fd, data, (unsigned int)length);
+#else
+        const ssize_t n = write(fd, data, length);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+#endif
+        if (n <= 0)
+        {
+            glitchedhttps_log_error("Failed to write the response body to the output file descriptor!", __func__);
+            return GLITCHEDHTTPS_OUTPUT_WRITE_FAILED;
+        }
+
+        data += n;
+        length -= n;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int response_reader_emit(void* response_reader, const char* data, const size_t length)
+{
+    struct response_reader* reader = (struct response_reader*)response_reader;
+    reader->response->content_length += length;
+
+    if (reader->request->output_fd > 0)
+    {
+        return write_to_fd(reader->request->output_fd, data, length);
+    }
+
+    if (reader->request->on_body(data, length, reader->request->userdata) != 0)
+    {
+        glitchedhttps_log_error("Response body reception aborted by the on_body callback.", __func__);
+        return GLITCHEDHTTPS_ABORTED_BY_CALLBACK;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int response_reader_deliver_body(struct response_reader* reader, char* data, size_t length)
+{
+    if (reader->done || length == 0)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    if (reader->head.chunked)
+    {
+        const int r = glitchedhttps_chunked_decode(&reader->chunked_decoder, data, length, &length);
+
+        /* Trailer fields might have made the header builder grow (and move). */
+        reader->response->headers = reader->header_builder.array;
+        reader->response->headers_count = reader->header_builder.length;
+
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            glitchedhttps_log_error("HTTP response parse error: invalid chunked transfer encoding!", __func__);
+            return r == GLITCHEDHTTPS_OUT_OF_MEM ? r : GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+        }
+        reader->done = glitchedhttps_chunked_decoder_done(&reader->chunked_decoder);
+    }
+    else if (reader->head.content_length_known)
+    {
+        if (length > reader->body_remaining)
+        {
+            length = reader->body_remaining;
+        }
+        reader->body_remaining -= length;
+        reader->done = reader->body_remaining == 0;
+    }
+
+    if (length == 0)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    if (reader->decoding.count > 0)
+    {
+        return glitchedhttps_decoding_pipeline_update(&reader->decoding, data, length);
+    }
+
+    return response_reader_emit(reader, data, length);
+}
+
+/** @private */
+static int response_reader_parse_head(struct response_reader* reader, char* head_end)
+{
+    char* begin = reader->buffer.array;
+    char* end = begin + reader->buffer.length;
+
+    reader->response = reader->target != NULL ? reader->target : new_response();
+    if (reader->response == NULL)
+    {
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    struct glitchedhttps_response_buffers* buffers = &reader->response->buffers;
+
+    /* When streaming, the raw response only contains the response head. */
+    const size_t head_length = head_end - begin;
+    reader->response->raw = take_buffer(buffers->raw, &buffers->raw_capacity, head_length + 1);
+    buffers->raw = NULL;
+
+    if (reader->response->raw == NULL)
+    {
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    memcpy(reader->response->raw, begin, head_length);
+    reader->response->raw[head_length] = '\0';
+
+    if (parse_response_head(begin, head_end, reader->response, &reader->header_builder, NULL, &reader->head) != GLITCHEDHTTPS_SUCCESS)
+    {
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    reader->body_remaining = reader->response->content_length;
+    reader->done = !response_has_body(reader->request, reader->response->status_code) || (reader->head.content_length_known && reader->body_remaining == 0);
+
+    /* From now on, content_length counts the (decompressed) body bytes that were passed on to the on_body callback (or written to the output file descriptor). */
+    reader->response->content_length = 0;
+
+    glitchedhttps_chunked_decoder_init(&reader->chunked_decoder, &push_chunked_header, &reader->header_builder);
+    init_decoding(reader->request, reader->response, &reader->decoding, &response_reader_emit, reader);
+
+    /* While the callback runs, the headers are borrowed straight from the builder. */
+    reader->response->headers = reader->header_builder.array;
+    reader->response->headers_count = reader->header_builder.length;
+
+    if (reader->request->on_headers != NULL && reader->request->on_headers(reader->response, reader->request->userdata) != 0)
+    {
+        glitchedhttps_log_error("Response reception aborted by the on_headers callback.", __func__);
+        return GLITCHEDHTTPS_ABORTED_BY_CALLBACK;
+    }
+
+    /* Whatever came in after the response head already belongs to the body. */
+    return response_reader_deliver_body(reader, head_end, end - head_end);
+}
+
+/**
+ * @private
+ * Finds the Content-Length header value inside a response head (only needed before the head is fully parsed).
+ * @return <code>1</code> if the response body size is known from a Content-Length header (and no chunked transfer encoding is used); <code>0</code> if not.
+ */
+static int scan_content_length(const char* begin, const char* head_end, size_t* out)
+{
+    int found = 0;
+    const char* current = find_delimiter(begin, head_end, header_delimiter, header_delimiter_length);
+
+    while (current != NULL && current < head_end)
+    {
+        current += header_delimiter_length;
+        const char* next = find_delimiter(current, head_end, header_delimiter, header_delimiter_length);
+        const char* line_end = next != NULL ? next : head_end;
+        const char* colon = memchr(current, ':', line_end - current);
+
+        if (colon != NULL)
+        {
+            switch (glitchedhttps_header_lookup(current, colon - current))
+            {
+                case GLITCHEDHTTPS_HEADER_CONTENT_LENGTH:
+                    if (!found)
+                    {
+                        *out = strtoull(colon + 1, NULL, 10);
+                        found = 1;
+                    }
+                    break;
+                case GLITCHEDHTTPS_HEADER_TRANSFER_ENCODING:
+                    /* Content-Length is meaningless for chunked bodies. */
+                    return 0;
+                default:
+                    break;
+            }
+        }
+
+        current = next;
+    }
+
+    return found;
+}
+
+/**
+ * @private
+ * Called once the head of a buffered response is complete: checks whether the response is already complete at this point
+ * (no body to expect) and otherwise grows the receive buffer exactly once, to the size of the response head plus its Content-Length
+ * (instead of letting it double its way up there, copying the received data around on every step).
+ */
+static int response_reader_scan_head(struct response_reader* reader, const char* head_end)
+{
+    const char* begin = reader->buffer.array;
+
+    if (!response_has_body(reader->request, response_head_status_code(begin, head_end)))
+    {
+        reader->done = 1;
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    size_t content_length = 0;
+    if (!scan_content_length(begin, head_end, &content_length))
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    if (content_length > SIZE_MAX - (head_end - begin))
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    reader->expected_length = (head_end - begin) + content_length;
+    reader->done = reader->buffer.length >= reader->expected_length;
+
+    if (content_length > GLITCHEDHTTPS_MAX_RECEIVE_BUFFER_PRESIZE)
+    {
+        content_length = GLITCHEDHTTPS_MAX_RECEIVE_BUFFER_PRESIZE;
+    }
+
+    const size_t capacity = (head_end - (const char*)reader->buffer.array) + content_length;
+    if (capacity <= reader->buffer.capacity)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    void* array = realloc(reader->buffer.array, capacity * reader->buffer.element_size);
+    if (array == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    glitchedhttps_stats_count_receive_buffer_growth(reader->buffer.array != array ? reader->buffer.length : 0);
+
+    reader->buffer.array = array;
+    reader->buffer.capacity = capacity;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int response_reader_feed(struct response_reader* reader, char* data, const size_t length)
+{
+    reader->received += length;
+
+    if (reader->streaming && reader->response != NULL)
+    {
+        return response_reader_deliver_body(reader, data, length);
+    }
+
+    const size_t previous_length = reader->buffer.length;
+    const size_t previous_capacity = reader->buffer.capacity;
+
+    if (chillbuff_push_back(&reader->buffer, data, length) != CHILLBUFF_SUCCESS)
+    {
+        glitchedhttps_log_error("Failed to append the received data to the response buffer!", __func__);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    if (reader->buffer.capacity != previous_capacity)
+    {
+        glitchedhttps_stats_count_receive_buffer_growth(previous_length);
+    }
+
+    if (reader->head_scanned)
+    {
+        reader->done = reader->expected_length > 0 && reader->buffer.length >= reader->expected_length;
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    const char* head_end = NULL;
+    size_t search_offset = previous_length > 3 ? previous_length - 3 : 0;
+
+    for (;;)
+    {
+        /* Look for the end of the response head, starting just before the newly received data (in case the delimiter was split across two reads). */
+        head_end = find_delimiter((const char*)reader->buffer.array + search_offset, (const char*)reader->buffer.array + reader->buffer.length, "\r\n\r\n", 4);
+
+        if (head_end == NULL)
+        {
+            return GLITCHEDHTTPS_SUCCESS;
+        }
+
+        const int status_code = response_head_status_code(reader->buffer.array, head_end);
+
+        /* 1xx responses are interim: they have no body and are followed by more responses (until the final one). 101 (Switching Protocols) is final though. */
+        if (status_code < 100 || status_code >= 200 || status_code == 101)
+        {
+            break;
+        }
+
+        if (status_code == 100)
+        {
+            reader->continue_received = 1;
+        }
+
+        const size_t interim_length = head_end + 4 - (const char*)reader->buffer.array;
+        memmove(reader->buffer.array, (char*)reader->buffer.array + interim_length, reader->buffer.length - interim_length);
+        reader->buffer.length -= interim_length;
+        search_offset = 0;
+    }
+
+    reader->head_scanned = 1;
+
+    if (!reader->streaming)
+    {
+        return response_reader_scan_head(reader, head_end + 4);
+    }
+
+    return response_reader_parse_head(reader, (char*)head_end + 4);
+}
+
+#ifdef __linux__
+
+/**
+ * @private
+ * Moves the rest of a plain (not chunked) response body from the socket to the output file descriptor with <code>splice()</code>,
+ * through a pipe and without the data ever being copied into userspace.
+ */
+static int response_reader_splice(struct response_reader* reader, const int sockfd)
+{
+    int pipefd[2];
+    if (pipe(pipefd) != 0)
+    {
+        reader->splice_unsupported = 1;
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    int exit_code = GLITCHEDHTTPS_SUCCESS;
+
+    while (!reader->done)
+    {
+        size_t max = 1 << 16;
+        if (reader->head.content_length_known && reader->body_remaining < max)
+        {
+            max = reader->body_remaining;
+        }
+
+        const ssize_t received = splice(sockfd, NULL, pipefd[1], NULL, max, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (received < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno == EINVAL && reader->response->content_length == 0)
+            {
+                /* Nothing moved yet: let the caller fall back to recv() + write(). */
+                reader->splice_unsupported = 1;
+                break;
+            }
+
+            glitchedhttps_log_error("HTTP request failed: \"splice()\" from the socket failed!", __func__);
+            exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
+            break;
+        }
+
+        if (received == 0)
+        {
+            /* EOF; ready to close the connection (response_reader_finish() then checks whether the body was complete). */
+            reader->splice_eof = 1;
+            break;
+        }
+
+        reader->received += received;
+
+        for (ssize_t left = received; left > 0;)
+        {
+            const ssize_t written = splice(pipefd[0], NULL, reader->request->output_fd, NULL, left, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (written < 0 && errno == EINTR)
+                continue;
+
+            if (written < 0 && errno == EINVAL)
+            {
+                /* The output fd doesn't support splice() (e.g. it was opened with O_APPEND): drain the pipe the ordinary way and stop splicing. */
+                char drain[4096];
+                while (left > 0)
+                {
+                    const ssize_t n = read(pipefd[0], drain, left < (ssize_t)sizeof(drain) ? (size_t)left : sizeof(drain));
+                    if (n <= 0 || write_to_fd(reader->request->output_fd, drain, n) != GLITCHEDHTTPS_SUCCESS)
+                    {
+                        exit_code = GLITCHEDHTTPS_OUTPUT_WRITE_FAILED;
+                        goto exit;
+                    }
+                    left -= n;
+                }
+                reader->splice_unsupported = 1;
+                break;
+            }
+
+            if (written <= 0)
+            {
+                glitchedhttps_log_error("Failed to splice the response body into the output file descriptor!", __func__);
+                exit_code = GLITCHEDHTTPS_OUTPUT_WRITE_FAILED;
+                goto exit;
+            }
+
+            left -= written;
+        }
+
+        reader->response->content_length += received;
+
+        if (reader->head.content_length_known)
+        {
+            reader->body_remaining -= received;
+            reader->done = reader->body_remaining == 0;
+        }
+
+        if (reader->splice_unsupported)
+            break;
+    }
+
+exit:
+    close(pipefd[0]);
+    close(pipefd[1]);
+    return exit_code;
+}
+
+#endif // __linux__
+
+/** @private */
+static int response_reader_finish(struct response_reader* reader, struct glitchedhttps_response** out)
+{
+    if (reader->received == 0)
+    {
+        glitchedhttps_log_error("HTTP response string empty!", __func__);
+        return GLITCHEDHTTPS_EMPTY_RESPONSE;
+    }
+
+    if (!reader->streaming)
+    {
+        return parse_response_string(&reader->buffer, reader->request, out);
+    }
+
+    if (reader->response == NULL)
+    {
+        glitchedhttps_log_error("HTTP response parse error: the connection was closed before the response headers were complete!", __func__);
+        return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+    }
+
+    /* Only a body without any framing (read until the connection is closed) is complete on EOF: a cut-off Content-Length or chunked body is an error. */
+    if (!reader->done && (reader->head.content_length_known || reader->head.chunked))
+    {
+        glitchedhttps_log_error("HTTP response parse error: the connection was closed before the whole response body was received!", __func__);
+        return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+    }
+
+    if (reader->decoding.count > 0)
+    {
+        /* Flush the decoders' remaining output (and make sure the compressed body wasn't truncated). */
+        const int r = glitchedhttps_decoding_pipeline_finish(&reader->decoding);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+    }
+
+    /* Take the final header list over from the builder (it may have grown by the chunked trailer fields). */
+    if (adopt_headers(reader->response, &reader->header_builder) != GLITCHEDHTTPS_SUCCESS)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    *out = reader->response;
+    reader->response = NULL;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * A piece of data to send (see connection::writev).
+ */
+struct send_buffer
+{
+    /** The data to send. */
+    const char* data;
+
+    /** How many bytes of \p data to send. */
+    size_t length;
+};
+
+/**
+ * @private
+ * An open connection (plain TCP socket or TLS session), as seen by the code that sends requests.
+ */
+struct connection
+{
+    /** Writes all of the passed data (looping over partial writes), returning a glitchedhttps exit code. */
+    int (*write)(void* ctx, const char* data, size_t length);
+
+    /** Writes all of the passed buffers, one after the other, without copying them together first (looping over partial writes). */
+    int (*writev)(void* ctx, const struct send_buffer* buffers, size_t buffers_count);
+
+    /** Reads whatever data is available (blocking until there is some): returns how many bytes were read, <code>0</code> if the server closed the connection, or a negative value on failure. */
+    int (*read)(void* ctx, char* buffer, size_t size);
+
+    /** How many bytes were already received and can be read without waiting for the socket (the TLS layer might hold some back). */
+    size_t (*pending)(void* ctx);
+
+    /** The socket or TLS context to write to. */
+    void* ctx;
+
+    /** The underlying socket (to wait on). */
+    int sockfd;
+};
+
+/** @private */
+static int socket_write(void* ctx, const char* data, size_t length)
+{
+    const int sockfd = *(const int*)ctx;
+
+    while (length > 0)
+    {
+        const int chunk = length > INT_MAX ? INT_MAX : (int)length;
+        const int sent = (int)send(sockfd, data, chunk, 0);
+
+        if (sent < 0)
+        {
+#ifndef _WIN32
+            if (errno == EINTR)
+                continue;
+#endif
+            glitchedhttps_log_error("Connection to server was successful but HTTP Request could not be transmitted!", __func__);
+            return GLITCHEDHTTPS_HTTP_REQUEST_TRANSMISSION_FAILED;
+        }
+
+        data += sent;
+        length -= sent;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Sends multiple buffers over a socket with as few system calls as possible: using <code>writev()</code> (scatter/gather I/O), or one <code>send()</code> per buffer on Windows.
+ */
+static int socket_writev(void* ctx, const struct send_buffer* buffers, size_t buffers_count)
+{
+#ifdef _WIN32
+    for (size_t i = 0; i < buffers_count; ++i)
+    {
+        const int r = socket_write(ctx, buffers[i].data, buffers[i].length);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+    }
+    return GLITCHEDHTTPS_SUCCESS;
+#else
+    const int sockfd = *(const int*)ctx;
+
+    struct iovec iov[8];
+    if (buffers_count > sizeof(iov) / sizeof(iov[0]))
+    {
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    size_t iov_count = 0;
+    for (size_t i = 0; i < buffers_count; ++i)
+    {
+        if (buffers[i].length == 0)
+            continue;
+
+        iov[iov_count].iov_base = (void*)buffers[i].data;
+        iov[iov_count].iov_len = buffers[i].length;
+        ++iov_count;
+    }
+
+    struct iovec* current = iov;
+
+    while (iov_count > 0)
+    {
+        const ssize_t sent = writev(sockfd, current, (int)iov_count);
+
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            glitchedhttps_log_error("Connection to server was successful but HTTP Request could not be transmitted!", __func__);
+            return GLITCHEDHTTPS_HTTP_REQUEST_TRANSMISSION_FAILED;
+        }
+
+        /* Skip over whatever was sent completely, and continue a partially sent buffer where it was left off. */
+        size_t n = (size_t)sent;
+
+        while (iov_count > 0 && n >= current->iov_len)
+        {
+            n -= current->iov_len;
+            ++current;
+            --iov_count;
+        }
+
+        if (iov_count > 0)
+        {
+            current->iov_base = (char*)current->iov_base + n;
+            current->iov_len -= n;
+        }
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+#endif
+}
+
+/** @private */
+static int socket_read(void* ctx, char* buffer, size_t size)
+{
+    const int sockfd = *(const int*)ctx;
+
+    for (;;)
+    {
+        const int n = (int)recv(sockfd, buffer, (int)(size > INT_MAX ? INT_MAX : size), 0);
+#ifndef _WIN32
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        return n;
+    }
+}
+
+/** @private */
+static size_t socket_pending(void* ctx)
+{
+    (void)ctx;
+
+    /* Whatever the kernel received is seen by poll(). */
+    return 0;
+}
+
+/** @private */
+static int ssl_write(void* ctx, const char* data, size_t length)
+{
+    mbedtls_ssl_context* ssl_context = (mbedtls_ssl_context*)ctx;
+
+    while (length > 0)
+    {
+        const int ret = mbedtls_ssl_write(ssl_context, (const unsigned char*)data, length);
+
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+            continue;
+
+        if (ret <= 0)
+        {
+            char error_msg[128];
+            snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_ssl_write\" returned %d", ret);
+            glitchedhttps_log_error(error_msg, __func__);
+            return GLITCHEDHTTPS_EXTERNAL_ERROR;
+        }
+
+        /* mbedtls_ssl_write() might only write part of the data (at most one TLS record's worth). */
+        data += ret;
+        length -= ret;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Sends multiple buffers through a TLS session as back-to-back TLS records (each buffer is encrypted straight from where it lies).
+ */
+static int ssl_writev(void* ctx, const struct send_buffer* buffers, size_t buffers_count)
+{
+    for (size_t i = 0; i < buffers_count; ++i)
+    {
+        const int r = ssl_write(ctx, buffers[i].data, buffers[i].length);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int ssl_read(void* ctx, char* buffer, size_t size)
+{
+    for (;;)
+    {
+        const int ret = mbedtls_ssl_read((mbedtls_ssl_context*)ctx, (unsigned char*)buffer, size);
+
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+            continue;
+
+        return ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY ? 0 : ret;
+    }
+}
+
+/** @private */
+static size_t ssl_pending(void* ctx)
+{
+    return mbedtls_ssl_get_bytes_avail((const mbedtls_ssl_context*)ctx);
+}
+
+/** @private Milliseconds on a monotonic clock (for timeouts). */
+static uint64_t monotonic_ms()
+{
+#ifdef _WIN32
+    return GetTickCount64();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+#endif
+}
+
+/**
+ * @private
+ * Waits until there's data to read on a socket (or the timeout expires).
+ * @return <code>1</code> if the socket is readable; <code>0</code> if the timeout expired; <code>-1</code> on failure.
+ */
+static int wait_readable(const int sockfd, const int timeout_ms)
+{
+#ifdef _WIN32
+    WSAPOLLFD fd = { (SOCKET)sockfd, POLLRDNORM, 0 };
+    const int r = WSAPoll(&fd, 1, timeout_ms);
+#else
+    struct pollfd fd = { sockfd, POLLIN, 0 };
+    int r;
+    do
+    {
+        r = poll(&fd, 1, timeout_ms);
+    } while (r < 0 && errno == EINTR);
+#endif
+    return r < 0 ? -1 : r > 0;
+}
+
+/** @private */
+static size_t request_content_length(const struct glitchedhttps_request* request)
+{
+    if (request->read_body != NULL)
+    {
+        /* Streamed bodies either have a known length or are sent using chunked transfer encoding (length zero). */
+        return request->content_length;
+    }
+
+    /* The request body is binary-safe: whenever a content_length is given, exactly that many bytes are sent (NUL bytes and all).
+     * Only if it was left at zero, the body is assumed to be a NUL-terminated string. */
+    return request->content == NULL ? 0 : request->content_length > 0 ? request->content_length : strlen(request->content);
+}
+
+/**
+ * @private
+ * Checks whether a request body is sent at all (bodies pulled from a glitchedhttps_request::read_body callback always are; other than that, only non-empty bodies with a content type are).
+ */
+static int request_has_body(const struct glitchedhttps_request* request)
+{
+    return request->read_body != NULL || (request->content_type != NULL && request_content_length(request) > 0);
+}
+
+/**
+ * @private
+ * Checks whether the request body needs to be compressed on the fly while it's being sent (using chunked transfer encoding, since the final size isn't known up front).
+ */
+static int request_body_is_compressed(const struct glitchedhttps_request* request)
+{
+    return request->compress_content != GLITCHEDHTTPS_CODING_IDENTITY && request_has_body(request);
+}
+
+/**
+ * @private
+ * Checks whether the request body is sent using chunked transfer encoding: that's the case if its final size isn't known up front
+ * (because it's compressed while it's sent, or because it's streamed from a glitchedhttps_request::read_body callback without a content length).
+ */
+static int request_body_is_chunked(const struct glitchedhttps_request* request)
+{
+    return request_body_is_compressed(request) || (request->read_body != NULL && request->content_length == 0);
+}
+
+/** @private How much room to leave in front of a chunk's data for its chunk size line (see write_chunk_in_place()). */
+#define GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE 16
+
+/**
+ * @private
+ * Sends \p length bytes of data as one chunk, framing it right where it lies: its chunk size line is written into the
+ * <code>GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE</code> bytes in front of \p data and the CRLF into the 2 bytes after it, so the whole chunk goes out with one write.
+ */
+static int write_chunk_in_place(const struct connection* connection, char* data, const size_t length)
+{
+    char size_line[GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE];
+    const int size_line_length = snprintf(size_line, sizeof(size_line), "%zx\r\n", length);
+
+    char* chunk = data - size_line_length;
+    memcpy(chunk, size_line, size_line_length);
+    memcpy(data + length, "\r\n", 2);
+
+    return connection->write(connection->ctx, chunk, size_line_length + length + 2);
+}
+
+/** @private */
+static int write_body_chunk(void* connection, const char* data, size_t length)
+{
+    const struct connection* c = (const struct connection*)connection;
+
+    /* Frame the data as one (or more) chunks and send each one in one go: chunk size line + data + CRLF. */
+    char frame[GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE + GLITCHEDHTTPS_ENCODER_CHUNK_SIZE + 2];
+    char* const frame_data = frame + GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE;
+
+    while (length > 0)
+    {
+        const size_t n = length < GLITCHEDHTTPS_ENCODER_CHUNK_SIZE ? length : GLITCHEDHTTPS_ENCODER_CHUNK_SIZE;
+
+        memcpy(frame_data, data, n);
+
+        const int r = write_chunk_in_place(c, frame_data, n);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+
+        data += n;
+        length -= n;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Pulls the request body out of the glitchedhttps_request::read_body callback one buffer at a time and sends (or compresses) each piece before asking for the next one. <p>
+ * The callback reads straight into the frame buffer from which uncompressed chunks are sent (no copying).
+ * @param encoder The content encoder to pass the body through (or <code>NULL</code> to send the body as it is).
+ * @param state The \p encoder state.
+ */
+static int pump_body_source(const struct connection* connection, const struct glitchedhttps_request* request, const struct glitchedhttps_content_encoder* encoder, void* state)
+{
+    char frame[GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE + GLITCHEDHTTPS_ENCODER_CHUNK_SIZE + 2];
+    char* const buffer = frame + GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE;
+
+    const int chunked = request_body_is_chunked(request);
+    const int known_length = request->content_length > 0;
+    size_t remaining = request->content_length;
+
+    while (!known_length || remaining > 0)
+    {
+        const size_t capacity = known_length && remaining < GLITCHEDHTTPS_ENCODER_CHUNK_SIZE ? remaining : GLITCHEDHTTPS_ENCODER_CHUNK_SIZE;
+        const ptrdiff_t n = request->read_body(buffer, capacity, request->userdata);
+
+        if (n < 0 || (size_t)n > capacity)
+        {
+            glitchedhttps_log_error("The request's \"read_body\" callback failed!", __func__);
+            return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+        }
+
+        if (n == 0)
+        {
+            if (known_length)
+            {
+                glitchedhttps_log_error("The request's \"read_body\" callback delivered less data than announced in the request's \"content_length\"!", __func__);
+                return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+            }
+            break;
+        }
+
+        int r;
+
+        if (encoder != NULL)
+            r = encoder->update(state, buffer, (size_t)n, &write_body_chunk, (void*)connection);
+        else if (chunked)
+            r = write_chunk_in_place(connection, buffer, (size_t)n);
+        else
+            r = connection->write(connection->ctx, buffer, (size_t)n);
+
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+
+        remaining -= known_length ? (size_t)n : 0;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Sends a request body that can't be sent as it is out of glitchedhttps_request::content: because it's compressed on the fly with the request's glitchedhttps_request::compress_content coding,
+ * and/or because it's pulled from the glitchedhttps_request::read_body callback. One piece is sent at a time (the whole (compressed) body never exists in memory at once).
+ */
+static int send_streamed_body(const struct connection* connection, const struct glitchedhttps_request* request)
+{
+    const struct glitchedhttps_content_encoder* encoder = NULL;
+    void* state = NULL;
+    int r = GLITCHEDHTTPS_SUCCESS;
+
+    if (request_body_is_compressed(request))
+    {
+        encoder = glitchedhttps_get_content_encoder(request->compress_content);
+        if (encoder == NULL)
+        {
+            return GLITCHEDHTTPS_INVALID_ARG;
+        }
+
+        r = encoder->init(&state);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+    }
+
+    if (request->read_body != NULL)
+        r = pump_body_source(connection, request, encoder, state);
+    else
+        r = encoder->update(state, request->content, request_content_length(request), &write_body_chunk, (void*)connection);
+
+    if (encoder != NULL)
+    {
+        if (r == GLITCHEDHTTPS_SUCCESS)
+        {
+            r = encoder->finish(state, &write_body_chunk, (void*)connection);
+        }
+
+        encoder->free(state);
+    }
+
+    if (r == GLITCHEDHTTPS_SUCCESS && request_body_is_chunked(request))
+    {
+        /* The last (zero-sized) chunk, followed by an empty trailer section. */
+        r = connection->write(connection->ctx, "0\r\n\r\n", 5);
+    }
+
+    return r;
+}
+
+/**
+ * @private
+ * Sends a request: first its serialized header section, then its body. <p>
+ * The body is sent straight out of the caller's glitchedhttps_request::content buffer (it's never copied): together with the headers in one <code>writev()</code> call for plain sockets, and as separate TLS records for TLS sessions.
+ */
+static int send_request(const struct connection* connection, const char* request_head, const size_t request_head_length, const struct glitchedhttps_request* request)
+{
+    if (request->read_body != NULL || request_body_is_compressed(request))
+    {
+        const int r = connection->write(connection->ctx, request_head, request_head_length);
+        return r == GLITCHEDHTTPS_SUCCESS ? send_streamed_body(connection, request) : r;
+    }
+
+    const struct send_buffer buffers[2] = {
+        { request_head, request_head_length },
+        { request->content, request_has_body(request) ? request_content_length(request) : 0 },
+    };
+
+    return connection->writev(connection->ctx, buffers, buffers[1].length > 0 ? 2 : 1);
+}
+
+/**
+ * @private
+ * Checks whether a request is sent with an <code>Expect: 100-continue</code> header (only requests with a body are).
+ */
+static int request_expects_continue(const struct glitchedhttps_request* request)
+{
+    return request->expect_continue && request_has_body(request);
+}
+
+/** @private Sends a request body on its own (after the request head was sent). */
+static int send_body(const struct connection* connection, const struct glitchedhttps_request* request)
+{
+    if (request->read_body != NULL || request_body_is_compressed(request))
+    {
+        return send_streamed_body(connection, request);
+    }
+
+    return connection->write(connection->ctx, request->content, request_content_length(request));
+}
+
+/**
+ * @private
+ * Sends an <code>Expect: 100-continue</code> request: first only its head, then - once the server said <code>100 Continue</code>,
+ * or if it didn't answer at all within the request's timeout - its body. <p>
+ * Whatever the server sends in the meantime is fed into the response reader (which skips the interim responses): if the server's final response
+ * arrives before the body was sent (e.g. because the upload was rejected), the body is never sent and the final response is read as usual.
+ * @param buffer Where to receive data into.
+ * @param buffer_size Size of the \p buffer.
+ */
+static int send_request_expecting_continue(const struct connection* connection, struct response_reader* reader, char* buffer, const size_t buffer_size, const char* request_head, const size_t request_head_length, const struct glitchedhttps_request* request)
+{
+    int r = connection->write(connection->ctx, request_head, request_head_length);
+    if (r != GLITCHEDHTTPS_SUCCESS)
+    {
+        return r;
+    }
+
+    const int timeout_ms = request->expect_continue_timeout_ms > 0 ? request->expect_continue_timeout_ms : GLITCHEDHTTPS_EXPECT_CONTINUE_TIMEOUT_MS;
+    const uint64_t deadline = monotonic_ms() + (uint64_t)timeout_ms;
+
+    while (!reader->continue_received && !reader->head_scanned)
+    {
+        if (connection->pending(connection->ctx) == 0)
+        {
+            const uint64_t now = monotonic_ms();
+
+            /* No answer in time: send the body anyway (the server might just not know about 100-continue). */
+            if (now >= deadline || (r = wait_readable(connection->sockfd, (int)(deadline - now))) == 0)
+            {
+                break;
+            }
+
+            if (r < 0)
+            {
+                glitchedhttps_log_error("Failed to wait for the server's \"100 Continue\" response!", __func__);
+                return GLITCHEDHTTPS_EXTERNAL_ERROR;
+            }
+        }
+
+        const int n = connection->read(connection->ctx, buffer, buffer_size);
+
+        if (n < 0)
+        {
+            glitchedhttps_log_error("Failed to read the server's answer to an \"Expect: 100-continue\" request head!", __func__);
+            return GLITCHEDHTTPS_EXTERNAL_ERROR;
+        }
+
+        if (n == 0)
+        {
+            /* The server closed the connection without sending any final response: leave it to the receiving side to find out. */
+            return GLITCHEDHTTPS_SUCCESS;
+        }
+
+        r = response_reader_feed(reader, buffer, (size_t)n);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+    }
+
+    if (reader->head_scanned)
+    {
+        /* The final response came first (e.g. 401 or 413): the body is not sent at all. */
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    return send_body(connection, request);
+}
+
+#undef GLITCHEDHTTPS_CHUNK_SIZE_LINE_SPACE
+
+/**
+ * @private
+ * Where a request goes: the parts of its URL that the transports need.
+ */
+struct request_target
+{
+    /** Whether to use TLS. */
+    int https;
+
+    /** NUL-terminated host name (or IP address) without the port: either the {@link #server_host_buffer} or an endpoint's host. */
+    const char* server_host;
+
+    /** Where the host name is copied to when the URL is parsed for just one request. */
+    char server_host_buffer[256];
+
+    /** The port to connect to. */
+    int server_port;
+
+    /** The host's resolved addresses if they were cached by a glitchedhttps_endpoint; <code>NULL</code> if the host needs to be resolved for every connection. */
+    const struct addrinfo* addresses;
+
+    /** The parsed URL. Its views point into the URL string, so they're only valid while the request head is being serialized! */
+    struct glitchedhttps_url url;
+};
+
+struct glitchedhttps_endpoint
+{
+    /** The endpoint's own copy of the URL (the {@link #url} views point into it). */
+    char* url_string;
+
+    /** The parsed URL. */
+    struct glitchedhttps_url url;
+
+    /** NUL-terminated copy of the host name (for the resolver and for TLS' server name indication). */
+    char host[256];
+
+    /** The host's resolved addresses. */
+    struct addrinfo* addresses;
+};
+
+/**
+ * @private
+ * Resolves a host name (or IP address) into the list of addresses to try connecting to.
+ */
+static int resolve_host(const char* server_host, const int server_port, struct addrinfo** out)
+{
+    struct addrinfo hints;
+    memset(&hints, 0x00, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    char port[8] = { 0x00 };
+    snprintf(port, sizeof(port), "%d", server_port);
+
+    *out = NULL;
+
+    const int ret = getaddrinfo(server_host, port, &hints, out);
+    if (ret != 0 || *out == NULL)
+    {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "\"getaddrinfo\" failed with error code: %d", ret);
+        glitchedhttps_log_error(msg, __func__);
+
+        if (*out != NULL)
+        {
+            freeaddrinfo(*out);
+            *out = NULL;
+        }
+
+        return GLITCHEDHTTPS_HTTP_GETADDRINFO_FAILED;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Opens a TCP connection to a request target: each of its addresses (cached by an endpoint, or resolved right here) is tried in turn until one accepts the connection.
+ */
+static int connect_to_target(const struct request_target* target, int* out_sockfd)
+{
+    struct addrinfo* resolved = NULL;
+    const struct addrinfo* addresses = target->addresses;
+
+    if (addresses == NULL)
+    {
+        const int r = resolve_host(target->server_host, target->server_port, &resolved);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+        addresses = resolved;
+    }
+
+    int sockfd = -1;
+
+    for (const struct addrinfo* address = addresses; address != NULL; address = address->ai_next)
+    {
+        sockfd = (int)socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (sockfd < 0)
+        {
+            continue;
+        }
+
+        if (connect(sockfd, address->ai_addr, (int)address->ai_addrlen) == 0)
+        {
+            break;
+        }
+
+        closesocket(sockfd);
+        sockfd = -1;
+    }
+
+    if (resolved != NULL)
+    {
+        freeaddrinfo(resolved);
+    }
+
+    if (sockfd < 0)
+    {
+        glitchedhttps_log_error("Connection to server failed!", __func__);
+        return GLITCHEDHTTPS_CONNECTION_TO_SERVER_FAILED;
+    }
+
+    *out_sockfd = sockfd;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Checks whether the server's certificate may be used for the negotiated key exchange (and for TLS server authentication at all):
+ * mbedtls only does this itself when it verifies the certificate chain during the handshake.
+ * The key usage check is mbedtls 2 only: the verified chain cache is unavailable with mbedtls 3, so the chain is always verified during the handshake there.
+ * @return The verification flags (<code>MBEDTLS_X509_BADCERT_KEY_USAGE</code> and/or <code>MBEDTLS_X509_BADCERT_EXT_KEY_USAGE</code>, or <code>0</code> if the certificate's usage is fine).
+ */
+static uint32_t check_server_cert_usage(const mbedtls_ssl_context* ssl_context, const mbedtls_x509_crt* leaf)
+{
+    uint32_t flags = 0;
+
+#if defined(MBEDTLS_X509_CHECK_KEY_USAGE) && MBEDTLS_VERSION_NUMBER < 0x03000000
+    const mbedtls_ssl_ciphersuite_t* ciphersuite = mbedtls_ssl_ciphersuite_from_string(mbedtls_ssl_get_ciphersuite(ssl_context));
+    unsigned int usage = 0;
+
+    switch (ciphersuite != NULL ? ciphersuite->key_exchange : MBEDTLS_KEY_EXCHANGE_NONE)
+    {
+        case MBEDTLS_KEY_EXCHANGE_RSA:
+        case MBEDTLS_KEY_EXCHANGE_RSA_PSK:
+            usage = MBEDTLS_X509_KU_KEY_ENCIPHERMENT;
+            break;
+        case MBEDTLS_KEY_EXCHANGE_DHE_RSA:
+        case MBEDTLS_KEY_EXCHANGE_ECDHE_RSA:
+        case MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA:
+            usage = MBEDTLS_X509_KU_DIGITAL_SIGNATURE;
+            break;
+        case MBEDTLS_KEY_EXCHANGE_ECDH_RSA:
+        case MBEDTLS_KEY_EXCHANGE_ECDH_ECDSA:
+            usage = MBEDTLS_X509_KU_KEY_AGREEMENT;
+            break;
+        default:
+            break;
+    }
+
+    if (mbedtls_x509_crt_check_key_usage(leaf, usage) != 0)
+    {
+        flags |= MBEDTLS_X509_BADCERT_KEY_USAGE;
+    }
+#else
+    (void)ssl_context;
+#endif
+
+#if defined(MBEDTLS_X509_CHECK_EXTENDED_KEY_USAGE)
+    if (mbedtls_x509_crt_check_extended_key_usage(leaf, MBEDTLS_OID_SERVER_AUTH, MBEDTLS_OID_SIZE(MBEDTLS_OID_SERVER_AUTH)) != 0)
+    {
+        flags |= MBEDTLS_X509_BADCERT_EXT_KEY_USAGE;
+    }
+#else
+    (void)leaf;
+#endif
+
+    return flags;
+}
+
+/**
+ * @private
+ * Checks whether the server's key (if it's an EC key) uses one of the curves that the SSL config allows (see glitchedhttps_tls_profile_apply()):
+ * mbedtls only does this itself when it verifies the certificate chain during the handshake (<code>mbedtls_ssl_check_curve()</code>).
+ * @return <code>MBEDTLS_X509_BADCERT_BAD_KEY</code> if the curve isn't allowed; <code>0</code> if it is (or if the key isn't an EC key).
+ */
+static uint32_t check_server_key_curve(const mbedtls_ssl_context* ssl_context, const mbedtls_x509_crt* leaf)
+{
+#if defined(MBEDTLS_ECP_C) && MBEDTLS_VERSION_NUMBER < 0x03000000
+    if (!mbedtls_pk_can_do(&leaf->pk, MBEDTLS_PK_ECKEY))
+    {
+        return 0;
+    }
+
+    const mbedtls_ecp_group_id curve = mbedtls_pk_ec(leaf->pk)->grp.id;
+
+    for (const mbedtls_ecp_group_id* id = ssl_context->conf->curve_list; id != NULL && *id != MBEDTLS_ECP_DP_NONE; ++id)
+    {
+        if (*id == curve)
+        {
+            return 0;
+        }
+    }
+
+    return MBEDTLS_X509_BADCERT_BAD_KEY;
+#else
+    (void)ssl_context;
+    (void)leaf;
+    return 0;
+#endif
+}
+
+/**
+ * @private
+ * Verifies the server's certificate chain after the handshake (which is what happens instead of mbedtls verifying it during the handshake when the verified chain cache is enabled):
+ * a chain that was verified for the same host before (and is still fresh) is taken from the cache, any other one is verified against the trust store and cached if it passes.
+ * @return The verification flags (see <code>mbedtls_ssl_get_verify_result()</code>): <code>0</code> if the chain can be trusted.
+ */
+static uint32_t verify_server_chain(const mbedtls_ssl_context* ssl_context, const char* host)
+{
+    const mbedtls_x509_crt* chain = mbedtls_ssl_get_peer_cert(ssl_context);
+    if (chain == NULL)
+    {
+        /* Same as what mbedtls reports when the verification couldn't even be attempted. */
+        return (uint32_t)-1;
+    }
+
+    /* The key usage depends on the negotiated cipher suite and the allowed curves on the TLS profile: neither is part of the cached chain, so both are checked on every handshake (they're cheap anyway). */
+    const uint32_t handshake_flags = check_server_cert_usage(ssl_context, chain) | check_server_key_curve(ssl_context, chain);
+    if (handshake_flags != 0)
+    {
+        return handshake_flags;
+    }
+
+    unsigned char key[GLITCHEDHTTPS_CHAINCACHE_KEY_SIZE];
+    const int cacheable = glitchedhttps_chaincache_key(host, chain, key) == 0;
+
+    if (cacheable && glitchedhttps_chaincache_lookup(key))
+    {
+        return 0;
+    }
+
+    int ret;
+    uint32_t flags = 0;
+
+#if defined(GLITCHEDHTTPS_LAZY_CA_CERTS) && defined(MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK)
+    if (lazy_ca_certs)
+    {
+        ret = mbedtls_x509_crt_verify_with_ca_cb((mbedtls_x509_crt*)chain, &glitchedhttps_truststore_ca_cb, NULL, &mbedtls_x509_crt_profile_default, host, &flags, NULL, NULL);
+    }
+    else
+#endif
+    {
+        ret = mbedtls_x509_crt_verify_with_profile((mbedtls_x509_crt*)chain, &cacert, NULL, &mbedtls_x509_crt_profile_default, host, &flags, NULL, NULL);
+    }
+
+    if (ret != 0 && flags == 0)
+    {
+        /* The verification itself failed (e.g. out of memory): never let that pass as a trusted chain. */
+        return (uint32_t)-1;
+    }
+
+    if (ret == 0 && flags == 0 && cacheable)
+    {
+        glitchedhttps_chaincache_store(key, chain);
+    }
+
+    return flags;
+}
+
+/** @private */
+static int https_request(const struct request_target* target, const char* request_head, const size_t request_head_length, const struct glitchedhttps_request* request, struct glitchedhttps_response** out)
+{
+    if (target == NULL || request_head == NULL || request == NULL || target->server_port <= 0)
+    {
+        glitchedhttps_log_error("INVALID HTTPS parameters passed into \"https_request\". Returning NULL...", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+#if defined WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        glitchedhttps_log_error("Error at \"WSAStartup\".", __func__);
+        return GLITCHEDHTTPS_EXTERNAL_ERROR;
+    }
+#endif
+
+    const size_t buffer_size = request->buffer_size;
+
+    struct response_reader reader;
+
+    int exit_code = response_reader_init(&reader, request, *out);
+    if (exit_code != GLITCHEDHTTPS_SUCCESS)
+    {
+        return exit_code;
+    }
+
+    uint32_t flags;
+    int ret = 1;
+    int mbedtls_exit_code = MBEDTLS_EXIT_FAILURE;
+
+    char error_msg[256] = { 0x00 };
+
+    unsigned char buffer_stack[GLITCHEDHTTPS_STACK_BUFFERSIZE];
+    unsigned char* buffer_heap = NULL;
+    if (buffer_size > sizeof(buffer_stack))
     {
         buffer_heap = malloc(buffer_size * sizeof(unsigned char));
         if (buffer_heap == NULL)
@@ -421,22 +2422,27 @@ static int https_request(const char* server_name, const int server_port, const c
         goto exit;
     }
 
-    /* Open the connection to the specified host. */
-
-    char port[8] = { 0x00 };
-    snprintf(port, sizeof(port), "%d", server_port);
+    /* Open the connection to the specified host (the TLS layer then runs on top of that socket). */
 
-    ret = mbedtls_net_connect(&net_context, server_name, port, MBEDTLS_NET_PROTO_TCP);
-    if (ret != 0)
+    exit_code = connect_to_target(target, &net_context.fd);
+    if (exit_code != GLITCHEDHTTPS_SUCCESS)
     {
-        snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_net_connect\" returned %d", ret);
-        glitchedhttps_log_error(error_msg, __func__);
-        exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
         goto exit;
     }
 
     mbedtls_ssl_conf_rng(&ssl_config, mbedtls_ctr_drbg_random, &ctr_drbg);
-    mbedtls_ssl_conf_authmode(&ssl_config, ssl_verification_optional ? MBEDTLS_SSL_VERIFY_OPTIONAL : MBEDTLS_SSL_VERIFY_REQUIRED);
+
+    /*
+     * With the verified chain cache, the server's certificate chain is verified (or found in the cache) right after the handshake: see verify_server_chain().
+     * The authmode for that is set on the shared config when the cache is switched on (see apply_chaincache_authmode()). Should the cache be switched while this request is underway,
+     * the chain is either verified twice or mbedtls reports it as unverified: it's never let through unverified.
+     */
+    const int verify_after_handshake = glitchedhttps_chaincache_enabled();
+
+    if (!verify_after_handshake)
+    {
+        mbedtls_ssl_conf_authmode(&ssl_config, request->ssl_verification_optional ? MBEDTLS_SSL_VERIFY_OPTIONAL : MBEDTLS_SSL_VERIFY_REQUIRED);
+    }
 
     ret = mbedtls_ssl_setup(&ssl_context, &ssl_config);
     if (ret != 0)
@@ -447,7 +2453,7 @@ static int https_request(const char* server_name, const int server_port, const c
         goto exit;
     }
 
-    ret = mbedtls_ssl_set_hostname(&ssl_context, server_name);
+    ret = mbedtls_ssl_set_hostname(&ssl_context, target->server_host);
     if (ret != 0)
     {
         snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_ssl_set_hostname\" returned %d", ret);
@@ -473,7 +2479,7 @@ static int https_request(const char* server_name, const int server_port, const c
 
     /* Verify the server's X.509 certificate. */
 
-    flags = mbedtls_ssl_get_verify_result(&ssl_context);
+    flags = verify_after_handshake ? verify_server_chain(&ssl_context, target->server_host) : mbedtls_ssl_get_verify_result(&ssl_context);
     if (flags != 0)
     {
         char verification_buffer[1024];
@@ -485,24 +2491,22 @@ static int https_request(const char* server_name, const int server_port, const c
 
     /* Write the request string.*/
 
-    while ((ret = mbedtls_ssl_write(&ssl_context, (const unsigned char*)request, strlen(request))) <= 0)
+    const struct connection connection = { &ssl_write, &ssl_writev, &ssl_read, &ssl_pending, &ssl_context, net_context.fd };
+
+    exit_code = request_expects_continue(request) //
+            ? send_request_expecting_continue(&connection, &reader, (char*)buffer, buffer_heap != NULL ? buffer_size : sizeof(buffer_stack), request_head, request_head_length, request) //
+            : send_request(&connection, request_head, request_head_length, request);
+    if (exit_code != GLITCHEDHTTPS_SUCCESS)
     {
-        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
-        {
-            snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_ssl_write\" returned %d", ret);
-            glitchedhttps_log_error(error_msg, __func__);
-            exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
-            goto exit;
-        }
+        goto exit;
     }
 
     /* Read the HTTP response. */
 
-    for (;;)
+    while (!reader.done)
     {
         const size_t length = (buffer_heap != NULL ? (buffer_size * sizeof(unsigned char)) : sizeof(buffer_stack));
-        memset(buffer, '\0', length);
-        ret = mbedtls_ssl_read(&ssl_context, buffer, length - 1);
+        ret = mbedtls_ssl_read(&ssl_context, buffer, length);
 
         if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
         {
@@ -516,179 +2520,500 @@ static int https_request(const char* server_name, const int server_port, const c
 
         if (ret < 0)
         {
-            snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_ssl_read\" returned %d", ret);
-            glitchedhttps_log_error(error_msg, __func__);
-            exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
-            goto exit;
+            snprintf(error_msg, sizeof(error_msg), "HTTPS request failed: \"mbedtls_ssl_read\" returned %d", ret);
+            glitchedhttps_log_error(error_msg, __func__);
+            exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
+            goto exit;
+        }
+
+        if (ret == 0)
+        {
+            /* EOF; ready to close the connection. */
+            break;
+        }
+
+        exit_code = response_reader_feed(&reader, (char*)buffer, ret);
+        if (exit_code != GLITCHEDHTTPS_SUCCESS)
+        {
+            goto exit;
+        }
+    }
+
+    exit_code = response_reader_finish(&reader, out);
+    mbedtls_ssl_close_notify(&ssl_context);
+    mbedtls_exit_code = MBEDTLS_EXIT_SUCCESS;
+
+exit:
+
+#ifdef MBEDTLS_ERROR_C
+    if (mbedtls_exit_code != MBEDTLS_EXIT_SUCCESS)
+    {
+        char error_buf[2048] = { 0x00 };
+        int f = snprintf(error_buf, sizeof(error_buf), "HTTPS request unsuccessful! Last error was: %d - ", ret);
+        mbedtls_strerror(ret, error_buf + f, sizeof(error_buf) - f - 1);
+        glitchedhttps_log_error(error_buf, __func__);
+    }
+#endif
+
+    free(buffer_heap);
+    mbedtls_net_free(&net_context);
+    mbedtls_ssl_free(&ssl_context);
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+    response_reader_free(&reader);
+    clear_win_sock();
+
+    return exit_code;
+}
+
+/** @private */
+static int http_request(const struct request_target* target, const char* request_head, const size_t request_head_length, const struct glitchedhttps_request* request, struct glitchedhttps_response** out)
+{
+    int exit_code, ret;
+
+    if (target == NULL || request_head == NULL || request == NULL || target->server_port <= 0)
+    {
+        glitchedhttps_log_error("INVALID HTTP parameters passed into \"http_request()\".", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+#if defined WIN32
+    WSADATA wsaData;
+    ret = WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (ret != 0)
+    {
+        glitchedhttps_log_error("Error at \"WSAStartup\".", __func__);
+        return GLITCHEDHTTPS_EXTERNAL_ERROR;
+    }
+#endif
+
+    const size_t buffer_size = request->buffer_size;
+
+    struct response_reader reader;
+
+    exit_code = response_reader_init(&reader, request, *out);
+    if (exit_code != GLITCHEDHTTPS_SUCCESS)
+    {
+        return exit_code;
+    }
+
+    int sockfd = -1;
+
+    exit_code = connect_to_target(target, &sockfd);
+    if (exit_code != GLITCHEDHTTPS_SUCCESS)
+    {
+        response_reader_free(&reader);
+        clear_win_sock();
+        return exit_code;
+    }
+
+    char buffer_stack[GLITCHEDHTTPS_STACK_BUFFERSIZE];
+    char* buffer_heap = NULL;
+    if (buffer_size > sizeof(buffer_stack))
+    {
+        buffer_heap = malloc(buffer_size * sizeof(char));
+        if (buffer_heap == NULL)
+        {
+            glitchedhttps_log_error("Buffer size too big; malloc failed! Using default (stack-allocated) buffer instead...", __func__);
+        }
+    }
+
+    char* buffer = buffer_heap != NULL ? buffer_heap : buffer_stack;
+
+    const struct connection connection = { &socket_write, &socket_writev, &socket_read, &socket_pending, &sockfd, sockfd };
+
+    exit_code = request_expects_continue(request) //
+            ? send_request_expecting_continue(&connection, &reader, buffer, buffer_heap != NULL ? buffer_size : sizeof(buffer_stack), request_head, request_head_length, request) //
+            : send_request(&connection, request_head, request_head_length, request);
+    if (exit_code != GLITCHEDHTTPS_SUCCESS)
+    {
+        goto exit;
+    }
+
+    while (!reader.done)
+    {
+#ifdef __linux__
+        if (reader.response != NULL && request->output_fd > 0 && !reader.head.chunked && reader.decoding.count == 0 && !reader.splice_unsupported)
+        {
+            exit_code = response_reader_splice(&reader, sockfd);
+            if (exit_code != GLITCHEDHTTPS_SUCCESS)
+            {
+                goto exit;
+            }
+            if (reader.splice_eof)
+            {
+                break;
+            }
+            continue;
+        }
+#endif
+        const int length = (int)(buffer_heap != NULL ? (buffer_size * sizeof(char)) : sizeof(buffer_stack));
+        ret = recv(sockfd, buffer, length, 0);
+
+        if (ret < 0)
+        {
+            char msg[128] = { 0x00 };
+            snprintf(msg, sizeof(msg), "HTTP request failed: \"recv()\" returned %d", ret);
+            glitchedhttps_log_error(msg, __func__);
+            exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
+            goto exit;
+        }
+
+        if (ret == 0)
+        {
+            /* EOF; ready to close the connection. */
+            break;
+        }
+
+        exit_code = response_reader_feed(&reader, buffer, ret);
+        if (exit_code != GLITCHEDHTTPS_SUCCESS)
+        {
+            goto exit;
+        }
+    }
+
+    exit_code = response_reader_finish(&reader, out);
+
+exit:
+    free(buffer_heap);
+    response_reader_free(&reader);
+    closesocket(sockfd);
+    clear_win_sock();
+    return exit_code;
+}
+
+/** @private */
+static int has_header(const struct glitchedhttps_request* request, const char* type, const size_t type_length)
+{
+    for (size_t i = 0; i < request->additional_headers_count; ++i)
+    {
+        const struct glitchedhttps_header* header = &request->additional_headers[i];
+        if (header->type != NULL && glitchedhttps_header_type_length(header) == type_length && glitchedhttps_strnequalic(header->type, type, type_length))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @private
+ * Finds out where a request goes: if it has a glitchedhttps_request::endpoint, everything is taken from there as it is; otherwise its URL is parsed.
+ */
+static int init_target(const struct glitchedhttps_request* request, struct request_target* target)
+{
+    const struct glitchedhttps_endpoint* endpoint = request->endpoint;
+
+    if (endpoint != NULL)
+    {
+        target->https = endpoint->url.https;
+        target->server_host = endpoint->host;
+        target->server_port = endpoint->url.port;
+        target->addresses = endpoint->addresses;
+        target->url = endpoint->url;
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    if (request->url == NULL)
+    {
+        glitchedhttps_log_error("URL parameter NULL!", __func__);
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    const int r = glitchedhttps_url_parse(request->url, request->url_length, &target->url);
+    if (r != GLITCHEDHTTPS_SUCCESS)
+    {
+        return r;
+    }
+
+    if (target->url.host_length >= sizeof(target->server_host_buffer))
+    {
+        glitchedhttps_log_error("Invalid URL: host name too long!", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    memcpy(target->server_host_buffer, target->url.host, target->url.host_length);
+    target->server_host_buffer[target->url.host_length] = '\0';
+
+    target->https = target->url.https;
+    target->server_host = target->server_host_buffer;
+    target->server_port = target->url.port;
+    target->addresses = NULL;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Serializes the request line and the request's general headers (Host, Connection, Accept-Encoding and the glitchedhttps_request::additional_headers) into \p request_string. <p>
+ * Neither the body related headers nor the empty line that ends the header section are written.
+ */
+static int serialize_request_head(chillbuff* request_string, const struct glitchedhttps_request* request, const struct request_target* target)
+{
+    char method[8] = { 0x00 };
+
+    if (!glitchedhttps_method_to_string(request->method, method, sizeof(method)))
+    {
+        glitchedhttps_log_error("HTTP request submission rejected due to invalid HTTP method name.", __func__);
+        return GLITCHEDHTTPS_INVALID_HTTP_METHOD_NAME;
+    }
+
+    const char whitespace[] = " ";
+    const size_t whitespace_length = 1;
+
+    const char http_version[] = "HTTP/1.1";
+    const size_t http_version_length = 8;
+
+    const char host[] = "Host: ";
+    const size_t host_length = 6;
+
+    const char connection[] = "Connection: Close";
+    const size_t connection_length = 17;
+
+    const char accept_encoding[] = "Accept-Encoding: ";
+    const size_t accept_encoding_length = 17;
+
+    chillbuff_push_back(request_string, method, strlen(method));
+    chillbuff_push_back(request_string, whitespace, whitespace_length);
+
+    if (target->url.path_length > 0)
+        chillbuff_push_back(request_string, target->url.path, target->url.path_length);
+    else
+        chillbuff_push_back(request_string, "/", 1);
+
+    if (target->url.query != NULL)
+    {
+        chillbuff_push_back(request_string, "?", 1);
+        chillbuff_push_back(request_string, target->url.query, target->url.query_length);
+    }
+
+    chillbuff_push_back(request_string, whitespace, whitespace_length);
+    chillbuff_push_back(request_string, http_version, http_version_length);
+    chillbuff_push_back(request_string, crlf, crlf_length);
+    chillbuff_push_back(request_string, host, host_length);
+    chillbuff_push_back(request_string, target->url.authority, target->url.authority_length);
+    chillbuff_push_back(request_string, crlf, crlf_length);
+    chillbuff_push_back(request_string, connection, connection_length);
+    chillbuff_push_back(request_string, crlf, crlf_length);
+
+    if (request->decompress_response && !has_header(request, "Accept-Encoding", 15))
+    {
+        /* Advertise whatever content decoders are available. */
+        char accept_encoding_value[256];
+        const size_t accept_encoding_value_length = glitchedhttps_get_accept_encoding(accept_encoding_value, sizeof(accept_encoding_value));
+
+        if (accept_encoding_value_length > 0)
+        {
+            chillbuff_push_back(request_string, accept_encoding, accept_encoding_length);
+            chillbuff_push_back(request_string, accept_encoding_value, accept_encoding_value_length);
+            chillbuff_push_back(request_string, crlf, crlf_length);
+        }
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static void serialize_headers(chillbuff* request_string, const struct glitchedhttps_header* headers, const size_t headers_count)
+{
+    const char header_separator[] = ": ";
+    const size_t header_separator_length = 2;
+
+    for (size_t i = 0; i < headers_count; ++i)
+    {
+        const struct glitchedhttps_header* header = &headers[i];
+
+        chillbuff_push_back(request_string, header->type, glitchedhttps_header_type_length(header));
+        chillbuff_push_back(request_string, header_separator, header_separator_length);
+        chillbuff_push_back(request_string, header->value, glitchedhttps_header_value_length(header));
+        chillbuff_push_back(request_string, crlf, crlf_length);
+    }
+}
+
+/**
+ * @private
+ * Serializes the headers that describe a request body (Content-Type, Content-Encoding and - if requested - Expect). <p>
+ * How the body is framed (Content-Length or Transfer-Encoding) is left out: see serialize_body_framing().
+ */
+static int serialize_content_headers(chillbuff* request_string, const struct glitchedhttps_request* request)
+{
+    const char content_type[] = "Content-Type: ";
+    const size_t content_type_length = 14;
+
+    const char content_encoding[] = "Content-Encoding: ";
+    const size_t content_encoding_length = 18;
+
+    const char expect_continue[] = "Expect: 100-continue";
+    const size_t expect_continue_length = 20;
+
+    const struct glitchedhttps_content_encoder* encoder = NULL;
+
+    if (request->compress_content != GLITCHEDHTTPS_CODING_IDENTITY)
+    {
+        encoder = glitchedhttps_get_content_encoder(request->compress_content);
+        if (encoder == NULL)
+        {
+            glitchedhttps_log_error("The requested request body compression is not available: glitchedhttps was built without the library that it needs (zlib for gzip, libzstd for zstd).", __func__);
+            return GLITCHEDHTTPS_INVALID_ARG;
+        }
+    }
+
+    if (request->content_type != NULL)
+    {
+        chillbuff_push_back(request_string, content_type, content_type_length);
+        chillbuff_push_back(request_string, request->content_type, request->content_type_length ? request->content_type_length : strlen(request->content_type));
+        chillbuff_push_back(request_string, crlf, crlf_length);
+    }
+
+    const size_t content_encoding_value_length = request->content_encoding == NULL ? 0 : request->content_encoding_length ? request->content_encoding_length : strlen(request->content_encoding);
+
+    if (content_encoding_value_length > 0 || encoder != NULL)
+    {
+        chillbuff_push_back(request_string, content_encoding, content_encoding_length);
+
+        if (content_encoding_value_length > 0)
+        {
+            chillbuff_push_back(request_string, request->content_encoding, content_encoding_value_length);
         }
 
-        if (ret == 0)
+        if (encoder != NULL)
         {
-            /* EOF; ready to close the connection. */
-            break;
+            /* Content codings are listed in the order in which they were applied. */
+            if (content_encoding_value_length > 0)
+            {
+                chillbuff_push_back(request_string, ", ", 2);
+            }
+            chillbuff_push_back(request_string, encoder->name, strlen(encoder->name));
         }
 
-        chillbuff_push_back(&response_string, buffer, ret);
+        chillbuff_push_back(request_string, crlf, crlf_length);
     }
 
-    if (response_string.length == 0)
+    if (request->expect_continue)
     {
-        glitchedhttps_log_error("HTTP response string empty!", __func__);
-        exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
-        goto exit;
+        chillbuff_push_back(request_string, expect_continue, expect_continue_length);
+        chillbuff_push_back(request_string, crlf, crlf_length);
     }
 
-    exit_code = parse_response_string(&response_string, out);
-    mbedtls_ssl_close_notify(&ssl_context);
-    mbedtls_exit_code = MBEDTLS_EXIT_SUCCESS;
+    return GLITCHEDHTTPS_SUCCESS;
+}
 
-exit:
+/**
+ * @private
+ * Serializes the header that says how the request body is framed: its Content-Length if its size is known up front,
+ * or chunked transfer encoding if it isn't (because it's compressed on the fly or streamed from a glitchedhttps_request::read_body callback without a content length).
+ */
+static void serialize_body_framing(chillbuff* request_string, const struct glitchedhttps_request* request)
+{
+    const char transfer_encoding_chunked[] = "Transfer-Encoding: chunked";
+    const size_t transfer_encoding_chunked_length = 26;
 
-#ifdef MBEDTLS_ERROR_C
-    if (mbedtls_exit_code != MBEDTLS_EXIT_SUCCESS)
+    const char content_length_header[] = "Content-Length: ";
+    const size_t content_length_header_length = 16;
+
+    if (request_body_is_chunked(request))
     {
-        char error_buf[2048] = { 0x00 };
-        int f = snprintf(error_buf, sizeof(error_buf), "HTTPS request unsuccessful! Last error was: %d - ", ret);
-        mbedtls_strerror(ret, error_buf + f, sizeof(error_buf) - f - 1);
-        glitchedhttps_log_error(error_buf, __func__);
+        /* The body is sent by the transport after the header section. */
+        chillbuff_push_back(request_string, transfer_encoding_chunked, transfer_encoding_chunked_length);
+        chillbuff_push_back(request_string, crlf, crlf_length);
+        return;
     }
-#endif
 
-    free(buffer_heap);
-    mbedtls_net_free(&net_context);
-    mbedtls_ssl_free(&ssl_context);
-    mbedtls_ctr_drbg_free(&ctr_drbg);
-    mbedtls_entropy_free(&entropy);
-    chillbuff_free(&response_string);
+    char content_length_value[64];
+    const int content_length_value_digits = snprintf(content_length_value, sizeof(content_length_value), "%zu", request_content_length(request));
 
-    return exit_code;
+    chillbuff_push_back(request_string, content_length_header, content_length_header_length);
+    chillbuff_push_back(request_string, content_length_value, content_length_value_digits);
+    chillbuff_push_back(request_string, crlf, crlf_length);
 }
 
-/** @private */
-static int http_request(const char* server_name, const int server_port, const char* request, const size_t buffer_size, struct glitchedhttps_response** out)
+/**
+ * @private
+ * Sends a request (its serialized header section plus the glitchedhttps_request::content body) and receives its response. <p>
+ * If <code>*out</code> isn't <code>NULL</code>, it's reset and refilled (and never freed here, even if the request fails);
+ * otherwise the response is taken from the calling thread's response pool (or newly allocated) and only written into <code>*out</code> on success.
+ */
+static int transmit(const struct request_target* target, const char* request_head, const size_t request_head_length, const struct glitchedhttps_request* request, struct glitchedhttps_response** out)
 {
-    int exit_code, ret;
-
-    if (server_name == NULL || request == NULL || server_port <= 0)
-    {
-        glitchedhttps_log_error("INVALID HTTP parameters passed into \"http_request()\".", __func__);
-        return GLITCHEDHTTPS_INVALID_ARG;
-    }
+    struct glitchedhttps_response* response = *out;
 
-#if defined WIN32
-    WSADATA wsaData;
-    ret = WSAStartup(MAKEWORD(2, 2), &wsaData);
-    if (ret != 0)
+    if (response != NULL)
     {
-        glitchedhttps_log_error("Error at \"WSAStartup\".", __func__);
-        return GLITCHEDHTTPS_EXTERNAL_ERROR;
+        glitchedhttps_response_reset(response);
     }
-#endif
-
-    chillbuff response_string;
-
-    if (chillbuff_init(&response_string, 1024, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
+    else
     {
-        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
-        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+        /* Refill a recycled response (if this thread has one) instead of allocating a new one. */
+        response = glitchedhttps_response_pool_take();
     }
 
-    struct addrinfo hints;
-    memset(&hints, 0x00, sizeof(hints));
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-
-    char port[8] = { 0x00 };
-    snprintf(port, sizeof(port), "%d", server_port);
-
-    struct addrinfo* res = NULL;
-    ret = getaddrinfo(server_name, port, &hints, &res);
-    if (ret != 0 || res == NULL)
-    {
-        char msg[128];
-        snprintf(msg, sizeof(msg), "\"getaddrinfo\" failed with error code: %d", ret);
-        glitchedhttps_log_error(msg, __func__);
-        chillbuff_free(&response_string);
-        if (res != NULL)
-            freeaddrinfo(res);
-        return GLITCHEDHTTPS_HTTP_GETADDRINFO_FAILED;
-    }
+    const int result = target->https //
+            ? https_request(target, request_head, request_head_length, request, &response) //
+            : http_request(target, request_head, request_head_length, request, &response);
 
-    char buffer_stack[GLITCHEDHTTPS_STACK_BUFFERSIZE];
-    char* buffer_heap = NULL;
-    if (buffer_size > sizeof(buffer_stack))
+    if (result != GLITCHEDHTTPS_SUCCESS)
     {
-        buffer_heap = malloc(buffer_size * sizeof(char));
-        if (buffer_heap == NULL)
+        if (*out == NULL)
         {
-            glitchedhttps_log_error("Buffer size too big; malloc failed! Using default (stack-allocated) buffer instead...", __func__);
+            glitchedhttps_response_recycle(response);
         }
+        return result;
     }
 
-    char* buffer = buffer_heap != NULL ? buffer_heap : buffer_stack;
+    *out = response;
+    return GLITCHEDHTTPS_SUCCESS;
+}
 
-    int sockfd = (int)socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+/** @private */
+static int submit(const struct glitchedhttps_request* request, struct glitchedhttps_response** out)
+{
+    struct request_target target;
 
-    if (connect(sockfd, res->ai_addr, (int)res->ai_addrlen) != 0)
+    int r = init_target(request, &target);
+    if (r != GLITCHEDHTTPS_SUCCESS)
     {
-        glitchedhttps_log_error("Connection to server failed!", __func__);
-        exit_code = GLITCHEDHTTPS_CONNECTION_TO_SERVER_FAILED;
-        goto exit;
+        return r;
     }
 
-    if (send(sockfd, request, (int)strlen(request), 0) < 0)
+    chillbuff request_string;
+
+    if (chillbuff_init(&request_string, 1024, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
     {
-        glitchedhttps_log_error("Connection to server was successful but HTTP Request could not be transmitted!", __func__);
-        exit_code = GLITCHEDHTTPS_HTTP_REQUEST_TRANSMISSION_FAILED;
-        goto exit;
+        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
     }
 
-    for (;;)
+    r = serialize_request_head(&request_string, request, &target);
+    if (r != GLITCHEDHTTPS_SUCCESS)
     {
-        const int length = (int)(buffer_heap != NULL ? (buffer_size * sizeof(char)) : sizeof(buffer_stack));
-        memset(buffer, '\0', length);
-        ret = recv(sockfd, buffer, length - 1, 0);
+        chillbuff_free(&request_string);
+        return r;
+    }
 
-        if (ret < 0)
-        {
-            char msg[128] = { 0x00 };
-            snprintf(msg, sizeof(msg), "HTTP request failed: \"recv()\" returned %d", ret);
-            glitchedhttps_log_error(msg, __func__);
-            exit_code = GLITCHEDHTTPS_EXTERNAL_ERROR;
-            goto exit;
-        }
+    serialize_headers(&request_string, request->additional_headers, request->additional_headers_count);
 
-        if (ret == 0)
+    if (request_has_body(request))
+    {
+        r = serialize_content_headers(&request_string, request);
+        if (r != GLITCHEDHTTPS_SUCCESS)
         {
-            /* EOF; ready to close the connection. */
-            break;
+            chillbuff_free(&request_string);
+            return r;
         }
 
-        chillbuff_push_back(&response_string, buffer, ret);
+        serialize_body_framing(&request_string, request);
     }
 
-    if (response_string.length == 0)
-    {
-        glitchedhttps_log_error("HTTP response string empty!", __func__);
-        exit_code = GLITCHEDHTTPS_EMPTY_RESPONSE;
-        goto exit;
-    }
+    /* The body isn't copied in here: the transport sends it straight from where it lies, right after the header section. */
+    chillbuff_push_back(&request_string, crlf, crlf_length);
 
-    exit_code = parse_response_string(&response_string, out);
+    r = transmit(&target, request_string.array, request_string.length, request, out);
 
-exit:
-    if (res != NULL)
-    {
-        freeaddrinfo(res);
-    }
-    free(buffer_heap);
-    chillbuff_free(&response_string);
-    closesocket(sockfd);
-    clear_win_sock();
-    return exit_code;
+    chillbuff_free(&request_string);
+    return r;
 }
 
-int glitchedhttps_submit(const struct glitchedhttps_request* request, struct glitchedhttps_response** out)
+/** @private */
+static int check_submit_args(const void* request, struct glitchedhttps_response** out)
 {
     if (!initialized)
     {
@@ -708,168 +3033,305 @@ int glitchedhttps_submit(const struct glitchedhttps_request* request, struct gli
         return GLITCHEDHTTPS_NULL_ARG;
     }
 
-    if (request->url == NULL)
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+int glitchedhttps_submit(const struct glitchedhttps_request* request, struct glitchedhttps_response** out)
+{
+    const int r = check_submit_args(request, out);
+    if (r != GLITCHEDHTTPS_SUCCESS)
     {
-        glitchedhttps_log_error("URL parameter NULL!", __func__);
-        return GLITCHEDHTTPS_NULL_ARG;
+        return r;
     }
 
-    if (request->url_length < 7 && strlen(request->url) < 7)
+    struct glitchedhttps_response* response = NULL;
+
+    const int result = submit(request, &response);
+    if (result != GLITCHEDHTTPS_SUCCESS)
     {
-        glitchedhttps_log_error("Invalid URL!", __func__);
-        return GLITCHEDHTTPS_INVALID_ARG;
+        return result;
+    }
+
+    *out = response;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+int glitchedhttps_submit_into(const struct glitchedhttps_request* request, struct glitchedhttps_response** response)
+{
+    const int r = check_submit_args(request, response);
+    if (r != GLITCHEDHTTPS_SUCCESS)
+    {
+        return r;
+    }
+
+    return submit(request, response);
+}
+
+/** @private */
+struct glitchedhttps_prepared
+{
+    /** Copy of the template request (for its flags and callbacks). Its url and header pointers are cleared; its content type points to {@link #content_type}. */
+    struct glitchedhttps_request request;
+
+    /** Where the requests go. Its URL views are cleared (they're only needed for serializing); if the template request had a glitchedhttps_request::endpoint, its cached addresses are used. */
+    struct request_target target;
+
+    /** The serialized request line and general headers, followed by two more bytes holding the CRLF that ends a header section. */
+    char* head;
+
+    /** Length of the {@link #head} (without the final CRLF). */
+    size_t head_length;
+
+    /** The serialized body headers (everything but the body framing), sent along with non-empty bodies. <code>NULL</code> if the template request has neither a content type nor a glitchedhttps_request::read_body callback (in which case no body is sent). */
+    char* content_head;
+
+    /** Length of the {@link #content_head}. */
+    size_t content_head_length;
+
+    /** Copy of the template request's content type. */
+    char* content_type;
+};
+
+struct glitchedhttps_prepared* glitchedhttps_prepare(const struct glitchedhttps_request* request)
+{
+    if (request == NULL)
+    {
+        glitchedhttps_log_error("Request parameter NULL!", __func__);
+        return NULL;
+    }
+
+    struct glitchedhttps_prepared* prepared = calloc(1, sizeof(struct glitchedhttps_prepared));
+    if (prepared == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return NULL;
     }
 
-    const int https = glitchedhttps_is_https(request->url);
-    const char* server_host_ptr = https ? request->url + 8 : glitchedhttps_is_http(request->url) ? request->url + 7 : NULL;
+    chillbuff builder;
+    if (chillbuff_init(&builder, 512, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
+    {
+        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
+        free(prepared);
+        return NULL;
+    }
 
-    if (server_host_ptr == NULL)
+    if (init_target(request, &prepared->target) != GLITCHEDHTTPS_SUCCESS || serialize_request_head(&builder, request, &prepared->target) != GLITCHEDHTTPS_SUCCESS)
     {
-        glitchedhttps_log_error("Missing or invalid protocol in passed URL: needs to be \"http://\" or \"https://\"", __func__);
-        return GLITCHEDHTTPS_INVALID_ARG;
+        goto error;
     }
 
-    char server_host[256] = { 0x00 };
+    serialize_headers(&builder, request->additional_headers, request->additional_headers_count);
 
-    char* path = strchr(server_host_ptr, '/');
-    strncpy(server_host, server_host_ptr, path == NULL ? strlen(server_host_ptr) : path - server_host_ptr);
+    prepared->head_length = builder.length;
+    chillbuff_push_back(&builder, crlf, crlf_length);
 
-    int server_port = https ? 443 : 80;
+    prepared->head = copy_string(builder.array, builder.length);
+    if (prepared->head == NULL)
+    {
+        goto out_of_mem;
+    }
 
-    char* custom_port = strrchr(server_host, ':');
-    if (custom_port != NULL)
+    if (request->content_type != NULL || request->read_body != NULL)
     {
-        /* IPv6 safety check. */
-        if (*server_host_ptr != '[' || *(custom_port - 1) == ']')
+        chillbuff_clear(&builder);
+
+        if (serialize_content_headers(&builder, request) != GLITCHEDHTTPS_SUCCESS)
         {
-            server_port = strtol(custom_port + 1, NULL, 10);
-            if (server_port <= 0 || server_port >= 65536)
-            {
-                char msg[128];
-                snprintf(msg, sizeof(msg), "Invalid port number \"%d\"", server_port);
-                glitchedhttps_log_error(msg, __func__);
-                return GLITCHEDHTTPS_INVALID_PORT_NUMBER;
-            }
-            memset(custom_port, '\0', strlen(custom_port));
+            goto error;
         }
-        else
+
+        prepared->content_head = copy_string(builder.array, builder.length);
+        prepared->content_head_length = builder.length;
+
+        if (prepared->content_head == NULL)
         {
-            custom_port = NULL;
+            goto out_of_mem;
         }
     }
 
-    if (path == NULL)
-        path = "/";
+    if (request->content_type != NULL)
+    {
+        prepared->content_type = copy_string(request->content_type, request->content_type_length ? request->content_type_length : strlen(request->content_type));
 
-    char method[8] = { 0x00 };
+        if (prepared->content_type == NULL)
+        {
+            goto out_of_mem;
+        }
+    }
 
-    if (!glitchedhttps_method_to_string(request->method, method, sizeof(method)))
+    chillbuff_free(&builder);
+
+    /* The URL views point into the template request's URL string, which isn't referenced anymore from here on. */
+    memset(&prepared->target.url, 0x00, sizeof(prepared->target.url));
+
+    prepared->request = *request;
+    prepared->request.url = NULL;
+    prepared->request.url_length = 0;
+    prepared->request.content = NULL;
+    prepared->request.content_length = 0;
+    prepared->request.content_type = prepared->content_type;
+    prepared->request.content_type_length = 0;
+    prepared->request.content_encoding = NULL;
+    prepared->request.content_encoding_length = 0;
+    prepared->request.additional_headers = NULL;
+    prepared->request.additional_headers_count = 0;
+
+    return prepared;
+
+out_of_mem:
+    glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+error:
+    chillbuff_free(&builder);
+    glitchedhttps_prepared_free(prepared);
+    return NULL;
+}
+
+int glitchedhttps_submit_prepared(const struct glitchedhttps_prepared* prepared, const char* content, const size_t content_length, const struct glitchedhttps_header* headers, const size_t headers_count, struct glitchedhttps_response** response)
+{
+    const int r = check_submit_args(prepared, response);
+    if (r != GLITCHEDHTTPS_SUCCESS)
     {
-        glitchedhttps_log_error("HTTP request submission rejected due to invalid HTTP method name.", __func__);
-        return GLITCHEDHTTPS_INVALID_HTTP_METHOD_NAME;
+        return r;
+    }
+
+    struct glitchedhttps_request request = prepared->request;
+    request.content = (char*)content;
+    request.content_length = content_length;
+
+    const int has_body = request_has_body(&request);
+
+    if (!has_body && headers_count == 0)
+    {
+        /* Nothing to add: the prepared header block (with its final CRLF) is the whole request. */
+        return transmit(&prepared->target, prepared->head, prepared->head_length + crlf_length, &request, response);
     }
 
     chillbuff request_string;
 
-    if (chillbuff_init(&request_string, 1024, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
+    /* Only the header section is assembled here: the body is sent straight from the caller's buffer. */
+    const size_t estimated_length = prepared->head_length + prepared->content_head_length + 256;
+    if (chillbuff_init(&request_string, estimated_length, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
     {
         glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper request string builder... Perhaps go check out the chillbuff error logs!", __func__);
         return GLITCHEDHTTPS_CHILLBUFF_ERROR;
     }
 
-    const char crlf[] = "\r\n";
-    const size_t crlf_length = strlen(crlf);
+    chillbuff_push_back(&request_string, prepared->head, prepared->head_length);
+    serialize_headers(&request_string, headers, headers_count);
 
-    const char whitespace[] = " ";
-    const size_t whitespace_length = 1;
+    if (has_body)
+    {
+        chillbuff_push_back(&request_string, prepared->content_head, prepared->content_head_length);
+        serialize_body_framing(&request_string, &request);
+    }
 
-    const char header_separator[] = ": ";
-    const size_t header_separator_length = 2;
+    chillbuff_push_back(&request_string, crlf, crlf_length);
 
-    const char http_version[] = "HTTP/1.1";
-    const size_t http_version_length = 8;
+    const int result = transmit(&prepared->target, request_string.array, request_string.length, &request, response);
 
-    const char host[] = "Host: ";
-    const size_t host_length = 6;
+    chillbuff_free(&request_string);
+    return result;
+}
 
-    const char content_type[] = "Content-Type: ";
-    const size_t content_type_length = 14;
+void glitchedhttps_prepared_free(struct glitchedhttps_prepared* prepared)
+{
+    if (prepared == NULL)
+    {
+        return;
+    }
 
-    const char content_length[] = "Content-Length: ";
-    const size_t content_length_strlen = 16;
+    free(prepared->head);
+    free(prepared->content_head);
+    free(prepared->content_type);
+    free(prepared);
+}
 
-    const char content_encoding[] = "Content-Encoding: ";
-    const size_t content_encoding_length = 18;
+struct glitchedhttps_endpoint* glitchedhttps_endpoint_init(const char* url, size_t url_length)
+{
+    if (url == NULL)
+    {
+        glitchedhttps_log_error("URL parameter NULL!", __func__);
+        return NULL;
+    }
 
-    const char connection[] = "Connection: Close";
-    const size_t connection_length = 17;
+    if (url_length == 0)
+    {
+        url_length = strlen(url);
+    }
 
-    chillbuff_push_back(&request_string, method, strlen(method));
-    chillbuff_push_back(&request_string, whitespace, whitespace_length);
-    chillbuff_push_back(&request_string, path, strlen(path));
-    chillbuff_push_back(&request_string, whitespace, whitespace_length);
-    chillbuff_push_back(&request_string, http_version, http_version_length);
-    chillbuff_push_back(&request_string, crlf, crlf_length);
-    chillbuff_push_back(&request_string, host, host_length);
-    chillbuff_push_back(&request_string, server_host, strlen(server_host));
-    chillbuff_push_back(&request_string, crlf, crlf_length);
-    chillbuff_push_back(&request_string, connection, connection_length);
-    chillbuff_push_back(&request_string, crlf, crlf_length);
+    struct glitchedhttps_endpoint* endpoint = calloc(1, sizeof(struct glitchedhttps_endpoint));
+    if (endpoint == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return NULL;
+    }
 
-    for (size_t i = 0; i < request->additional_headers_count; ++i)
+    endpoint->url_string = copy_string(url, url_length);
+    if (endpoint->url_string == NULL)
     {
-        struct glitchedhttps_header header = request->additional_headers[i];
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        free(endpoint);
+        return NULL;
+    }
 
-        chillbuff_push_back(&request_string, header.type, strlen(header.type));
-        chillbuff_push_back(&request_string, header_separator, header_separator_length);
-        chillbuff_push_back(&request_string, header.value, strlen(header.value));
-        chillbuff_push_back(&request_string, crlf, crlf_length);
+    if (glitchedhttps_url_parse(endpoint->url_string, url_length, &endpoint->url) != GLITCHEDHTTPS_SUCCESS)
+    {
+        goto error;
     }
 
-    if (request->content != NULL && request->content_type != NULL && request->content_length > 0)
+    if (endpoint->url.host_length >= sizeof(endpoint->host))
     {
-        if (strlen(request->content) > 0)
-        {
-            chillbuff_push_back(&request_string, content_type, content_type_length);
-            chillbuff_push_back(&request_string, request->content_type, request->content_type_length ? request->content_type_length : strlen(request->content_type));
-            chillbuff_push_back(&request_string, crlf, crlf_length);
+        glitchedhttps_log_error("Invalid URL: host name too long!", __func__);
+        goto error;
+    }
 
-            if (request->content_encoding != NULL)
-            {
-                const size_t content_encoding_value_length = request->content_encoding_length ? request->content_encoding_length : strlen(request->content_encoding);
-                if (content_encoding_value_length > 0)
-                {
-                    chillbuff_push_back(&request_string, content_encoding, content_encoding_length);
-                    chillbuff_push_back(&request_string, request->content_encoding, content_encoding_value_length);
-                    chillbuff_push_back(&request_string, crlf, crlf_length);
-                }
-            }
+    memcpy(endpoint->host, endpoint->url.host, endpoint->url.host_length);
+    endpoint->host[endpoint->url.host_length] = '\0';
 
-            chillbuff_push_back(&request_string, content_length, content_length_strlen);
-            char content_length_value[64];
-            const int content_length_value_digits = snprintf(content_length_value, sizeof(content_length_value), "%zu", request->content_length);
-            chillbuff_push_back(&request_string, content_length_value, content_length_value_digits);
+#if defined WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        glitchedhttps_log_error("Error at \"WSAStartup\".", __func__);
+        goto error;
+    }
+#endif
 
-            chillbuff_push_back(&request_string, crlf, crlf_length);
-            chillbuff_push_back(&request_string, crlf, crlf_length);
-            chillbuff_push_back(&request_string, request->content, strlen(request->content));
-            chillbuff_push_back(&request_string, crlf, crlf_length);
-        }
+    if (resolve_host(endpoint->host, endpoint->url.port, &endpoint->addresses) != GLITCHEDHTTPS_SUCCESS)
+    {
+        clear_win_sock();
+        goto error;
     }
 
-    chillbuff_push_back(&request_string, crlf, crlf_length);
+    return endpoint;
 
-    int result = https //
-            ? https_request(server_host, server_port, request_string.array, request->buffer_size, request->ssl_verification_optional, out) //
-            : http_request(server_host, server_port, request_string.array, request->buffer_size, out);
+error:
+    free(endpoint->url_string);
+    free(endpoint);
+    return NULL;
+}
 
-    chillbuff_free(&request_string);
-    return result;
+const struct glitchedhttps_url* glitchedhttps_endpoint_get_url(const struct glitchedhttps_endpoint* endpoint)
+{
+    return endpoint != NULL ? &endpoint->url : NULL;
+}
+
+void glitchedhttps_endpoint_free(struct glitchedhttps_endpoint* endpoint)
+{
+    if (endpoint == NULL)
+    {
+        return;
+    }
+
+    freeaddrinfo(endpoint->addresses);
+    clear_win_sock();
+
+    free(endpoint->url_string);
+    free(endpoint);
 }
 
 #undef closesocket
 #undef GLITCHEDHTTPS_MAX
-#undef GLITCHEDHTTPS_DEFAULT_CHUNK_BUFFERSIZE
 
 #ifdef __cplusplus
 } // extern "C"
@@ -26,6 +26,15 @@ static size_t CUSTOM_CA_CERTS_LEN = 0;
 static char* CA_CERTS = NULL;
 static size_t CA_CERTS_LEN = 0;
 
+static const char* CA_CERTS_DIR = NULL;
+
+#ifdef GLITCHEDHTTPS_EMBEDDED_CA_CERTS
+/* Generated from the bundle at the bottom of this file at build time (see tools/glitchedhttps_cacerts_der.c). */
+extern const unsigned char glitchedhttps_cacerts_der[];
+extern const size_t glitchedhttps_cacerts_der_lengths[];
+extern const size_t glitchedhttps_cacerts_der_count;
+#endif
+
 void glitchedhttps_set_custom_ca_certs(char* ca_certs)
 {
     if (ca_certs == NULL)
@@ -39,6 +48,16 @@ void glitchedhttps_set_custom_ca_certs(char* ca_certs)
     CUSTOM_CA_CERTS_LEN = strlen(ca_certs) + 1;
 }
 
+void glitchedhttps_set_ca_certs_dir(const char* directory)
+{
+    CA_CERTS_DIR = directory;
+}
+
+const char* glitchedhttps_get_ca_certs_dir()
+{
+    return CUSTOM_CA_CERTS == NULL ? CA_CERTS_DIR : NULL;
+}
+
 size_t glitchedhttps_get_ca_certs_length()
 {
     if (CUSTOM_CA_CERTS != NULL)
@@ -49,6 +68,34 @@ size_t glitchedhttps_get_ca_certs_length()
     return CA_CERTS_LEN;
 }
 
+const unsigned char* glitchedhttps_get_ca_certs_der(const size_t** lengths, size_t* count)
+{
+    const unsigned char* der = NULL;
+    const size_t* der_lengths = NULL;
+    size_t der_count = 0;
+
+#ifdef GLITCHEDHTTPS_EMBEDDED_CA_CERTS
+    if (CUSTOM_CA_CERTS == NULL && CA_CERTS_DIR == NULL)
+    {
+        der = glitchedhttps_cacerts_der;
+        der_lengths = glitchedhttps_cacerts_der_lengths;
+        der_count = glitchedhttps_cacerts_der_count;
+    }
+#endif
+
+    if (lengths != NULL)
+    {
+        *lengths = der_lengths;
+    }
+
+    if (count != NULL)
+    {
+        *count = der_count;
+    }
+
+    return der;
+}
+
 const char* glitchedhttps_get_ca_certs()
 {
     if (CUSTOM_CA_CERTS != NULL)
@@ -0,0 +1,269 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/sha256.h>
+#include <mbedtls/version.h>
+
+#include "glitchedhttps_chaincache.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * Before mbedtls 2.18 the peer certificate chain was always kept after the handshake: since then it's optional.
+ * In mbedtls 3 the negotiated key exchange (which the server certificate's key usage is checked against) isn't public API anymore: leave the verification to the handshake there.
+ */
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+#define GLITCHEDHTTPS_CHAINCACHE_AVAILABLE 0
+#elif MBEDTLS_VERSION_NUMBER >= 0x02120000 && !defined(MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+#define GLITCHEDHTTPS_CHAINCACHE_AVAILABLE 0
+#else
+#define GLITCHEDHTTPS_CHAINCACHE_AVAILABLE 1
+#endif
+
+#if defined(_MSC_VER)
+#define GLITCHEDHTTPS_THREAD_LOCAL __declspec(thread)
+#else
+#define GLITCHEDHTTPS_THREAD_LOCAL _Thread_local
+#endif
+
+/* The time to live and the generation are shared by all threads (like the counters in glitchedhttps_stats.c): use atomics wherever C11 atomics are available. */
+#if !defined(__STDC_NO_ATOMICS__) && !defined(_MSC_VER)
+#include <stdatomic.h>
+#define GLITCHEDHTTPS_SHARED(type) _Atomic type
+#define GLITCHEDHTTPS_SHARED_LOAD(shared) atomic_load_explicit(&(shared), memory_order_relaxed)
+#define GLITCHEDHTTPS_SHARED_STORE(shared, n) atomic_store_explicit(&(shared), (n), memory_order_relaxed)
+#else
+#define GLITCHEDHTTPS_SHARED(type) volatile type
+#define GLITCHEDHTTPS_SHARED_LOAD(shared) (shared)
+#define GLITCHEDHTTPS_SHARED_STORE(shared, n) ((shared) = (n))
+#endif
+
+/** @private A verified certificate chain. */
+struct verified_chain
+{
+    unsigned char key[GLITCHEDHTTPS_CHAINCACHE_KEY_SIZE];
+
+    /** When the chain was verified. */
+    time_t verified_at;
+
+    /** Store order (within the thread): the entry with the lowest one gets evicted first. */
+    uint64_t sequence;
+
+    /** The earliest expiry date of the chain's certificates. */
+    mbedtls_x509_time valid_to;
+
+    /** The value of {@link #generation} when the chain was verified: entries of older generations are stale. */
+    unsigned int generation;
+};
+
+/** @private */
+static GLITCHEDHTTPS_SHARED(uint32_t) ttl = GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_TTL;
+
+/** @private Bumped by glitchedhttps_chaincache_clear(): the thread-local caches can't be reached from another thread, so their entries are invalidated this way instead. Starts at 1 so that zeroed entries are never valid. */
+static GLITCHEDHTTPS_SHARED(unsigned int) generation = 1;
+
+/** @private */
+static GLITCHEDHTTPS_THREAD_LOCAL struct verified_chain cache[GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_SIZE];
+
+/** @private */
+static GLITCHEDHTTPS_THREAD_LOCAL uint64_t cache_sequence = 0;
+
+void glitchedhttps_chaincache_set_ttl(const uint32_t seconds)
+{
+    GLITCHEDHTTPS_SHARED_STORE(ttl, seconds);
+}
+
+uint32_t glitchedhttps_get_verified_chain_cache_ttl()
+{
+    return GLITCHEDHTTPS_SHARED_LOAD(ttl);
+}
+
+int glitchedhttps_chaincache_enabled()
+{
+    return GLITCHEDHTTPS_CHAINCACHE_AVAILABLE && GLITCHEDHTTPS_SHARED_LOAD(ttl) > 0;
+}
+
+int glitchedhttps_chaincache_key(const char* host, const struct mbedtls_x509_crt* chain, unsigned char* key)
+{
+    int ret;
+    mbedtls_sha256_context sha256;
+    mbedtls_sha256_init(&sha256);
+
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+#define GLITCHEDHTTPS_SHA256_STARTS mbedtls_sha256_starts
+#define GLITCHEDHTTPS_SHA256_UPDATE mbedtls_sha256_update
+#define GLITCHEDHTTPS_SHA256_FINISH mbedtls_sha256_finish
+#else
+#define GLITCHEDHTTPS_SHA256_STARTS mbedtls_sha256_starts_ret
+#define GLITCHEDHTTPS_SHA256_UPDATE mbedtls_sha256_update_ret
+#define GLITCHEDHTTPS_SHA256_FINISH mbedtls_sha256_finish_ret
+#endif
+
+    /* The host name's NUL-terminator and the length in front of each certificate keep the concatenation unambiguous. */
+
+    if ((ret = GLITCHEDHTTPS_SHA256_STARTS(&sha256, 0)) != 0 || (ret = GLITCHEDHTTPS_SHA256_UPDATE(&sha256, (const unsigned char*)host, strlen(host) + 1)) != 0)
+    {
+        goto exit;
+    }
+
+    for (const mbedtls_x509_crt* crt = chain; crt != NULL && crt->raw.p != NULL; crt = crt->next)
+    {
+        const unsigned char length[4] = {
+            (unsigned char)(crt->raw.len >> 24),
+            (unsigned char)(crt->raw.len >> 16),
+            (unsigned char)(crt->raw.len >> 8),
+            (unsigned char)(crt->raw.len),
+        };
+
+        if ((ret = GLITCHEDHTTPS_SHA256_UPDATE(&sha256, length, sizeof(length))) != 0 || (ret = GLITCHEDHTTPS_SHA256_UPDATE(&sha256, crt->raw.p, crt->raw.len)) != 0)
+        {
+            goto exit;
+        }
+    }
+
+    ret = GLITCHEDHTTPS_SHA256_FINISH(&sha256, key);
+
+#undef GLITCHEDHTTPS_SHA256_STARTS
+#undef GLITCHEDHTTPS_SHA256_UPDATE
+#undef GLITCHEDHTTPS_SHA256_FINISH
+
+exit:
+    mbedtls_sha256_free(&sha256);
+    return ret;
+}
+
+/** @private */
+static int is_fresh(const struct verified_chain* entry, const time_t now)
+{
+    return entry->generation == GLITCHEDHTTPS_SHARED_LOAD(generation) //
+            && now >= entry->verified_at //
+            && (uint64_t)(now - entry->verified_at) < GLITCHEDHTTPS_SHARED_LOAD(ttl) //
+            && !mbedtls_x509_time_is_past(&entry->valid_to);
+}
+
+int glitchedhttps_chaincache_lookup(const unsigned char* key)
+{
+    if (!glitchedhttps_chaincache_enabled())
+    {
+        return 0;
+    }
+
+    const time_t now = time(NULL);
+
+    for (size_t i = 0; i < GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_SIZE; ++i)
+    {
+        if (memcmp(cache[i].key, key, GLITCHEDHTTPS_CHAINCACHE_KEY_SIZE) == 0)
+        {
+            return is_fresh(&cache[i], now);
+        }
+    }
+
+    return 0;
+}
+
+/** @private */
+static int time_is_before(const mbedtls_x509_time* a, const mbedtls_x509_time* b)
+{
+    const int lhs[] = { a->year, a->mon, a->day, a->hour, a->min, a->sec };
+    const int rhs[] = { b->year, b->mon, b->day, b->hour, b->min, b->sec };
+
+    for (size_t i = 0; i < sizeof(lhs) / sizeof(lhs[0]); ++i)
+    {
+        if (lhs[i] != rhs[i])
+            return lhs[i] < rhs[i];
+    }
+
+    return 0;
+}
+
+void glitchedhttps_chaincache_store(const unsigned char* key, const struct mbedtls_x509_crt* chain)
+{
+    if (!glitchedhttps_chaincache_enabled() || chain == NULL)
+    {
+        return;
+    }
+
+    const time_t now = time(NULL);
+
+    /* Take the slot of the same chain if it's in there already, otherwise the first one that's stale (or empty), otherwise the least recently verified one. */
+
+    struct verified_chain* slot = &cache[0];
+
+    for (size_t i = 0; i < GLITCHEDHTTPS_VERIFIED_CHAIN_CACHE_SIZE; ++i)
+    {
+        struct verified_chain* entry = &cache[i];
+
+        if (memcmp(entry->key, key, GLITCHEDHTTPS_CHAINCACHE_KEY_SIZE) == 0)
+        {
+            slot = entry;
+            break;
+        }
+
+        if (!is_fresh(entry, now))
+        {
+            if (is_fresh(slot, now))
+                slot = entry;
+            continue;
+        }
+
+        if (is_fresh(slot, now) && entry->sequence < slot->sequence)
+        {
+            slot = entry;
+        }
+    }
+
+    memcpy(slot->key, key, GLITCHEDHTTPS_CHAINCACHE_KEY_SIZE);
+    slot->verified_at = now;
+    slot->sequence = ++cache_sequence;
+    slot->generation = GLITCHEDHTTPS_SHARED_LOAD(generation);
+    slot->valid_to = chain->valid_to;
+
+    for (const mbedtls_x509_crt* crt = chain->next; crt != NULL && crt->raw.p != NULL; crt = crt->next)
+    {
+        if (time_is_before(&crt->valid_to, &slot->valid_to))
+        {
+            slot->valid_to = crt->valid_to;
+        }
+    }
+}
+
+void glitchedhttps_chaincache_clear()
+{
+    /* Zero is what the entries of a fresh thread hold: skip it. Two threads clearing at once may bump it only once, which invalidates everything all the same. */
+    unsigned int next = GLITCHEDHTTPS_SHARED_LOAD(generation) + 1;
+    if (next == 0)
+    {
+        next = 1;
+    }
+
+    GLITCHEDHTTPS_SHARED_STORE(generation, next);
+}
+
+#undef GLITCHEDHTTPS_THREAD_LOCAL
+#undef GLITCHEDHTTPS_SHARED
+#undef GLITCHEDHTTPS_SHARED_LOAD
+#undef GLITCHEDHTTPS_SHARED_STORE
+#undef GLITCHEDHTTPS_CHAINCACHE_AVAILABLE
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,381 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_chunked.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include <stdint.h>
+#include <string.h>
+
+#define GLITCHEDHTTPS_CHUNKED_STATE_SIZE 0
+#define GLITCHEDHTTPS_CHUNKED_STATE_DATA 1
+#define GLITCHEDHTTPS_CHUNKED_STATE_DATA_CR 2
+#define GLITCHEDHTTPS_CHUNKED_STATE_DATA_LF 3
+#define GLITCHEDHTTPS_CHUNKED_STATE_TRAILER 4
+#define GLITCHEDHTTPS_CHUNKED_STATE_DONE 5
+
+void glitchedhttps_chunked_decoder_init(struct glitchedhttps_chunked_decoder* decoder, glitchedhttps_chunked_header_callback on_header, void* on_header_ctx)
+{
+    if (decoder == NULL)
+        return;
+
+    decoder->state = GLITCHEDHTTPS_CHUNKED_STATE_SIZE;
+    decoder->chunk_remaining = 0;
+    decoder->line_length = 0;
+    decoder->on_header = on_header;
+    decoder->on_header_ctx = on_header_ctx;
+}
+
+int glitchedhttps_chunked_decoder_done(const struct glitchedhttps_chunked_decoder* decoder)
+{
+    return decoder != NULL && decoder->state == GLITCHEDHTTPS_CHUNKED_STATE_DONE;
+}
+
+/** @private */
+static int is_whitespace(const char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+/** @private */
+static void trim(const char** string, size_t* length)
+{
+    while (*length > 0 && is_whitespace(**string))
+    {
+        ++(*string);
+        --(*length);
+    }
+
+    while (*length > 0 && is_whitespace((*string)[*length - 1]))
+    {
+        --(*length);
+    }
+}
+
+/** @private A token character (RFC 9110, section 5.6.2). */
+static int is_tchar(const char c)
+{
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+        return 1;
+
+    return c != '\0' && strchr("!#$%&'*+-.^_`|~", c) != NULL;
+}
+
+/** @private Gets the length of the token that starts at \p i (<code>0</code> if there's none). */
+static size_t skip_token(const char* line, const size_t line_length, size_t i)
+{
+    const size_t begin = i;
+
+    while (i < line_length && is_tchar(line[i]))
+    {
+        ++i;
+    }
+
+    return i - begin;
+}
+
+/**
+ * @private
+ * Skips the quoted-string (RFC 9110, section 5.6.4) that starts at \p i (with its opening DQUOTE).
+ * @return The length of the quoted string including both DQUOTEs; <code>0</code> if it's unterminated or contains a character that isn't allowed in there.
+ */
+static size_t skip_quoted_string(const char* line, const size_t line_length, size_t i)
+{
+    const size_t begin = i++;
+
+    while (i < line_length)
+    {
+        const unsigned char c = (unsigned char)line[i++];
+
+        if (c == '"')
+            return i - begin;
+
+        if (c == '\\')
+        {
+            if (i == line_length)
+                return 0;
+
+            /* quoted-pair = "\" ( HTAB / SP / VCHAR / obs-text ) */
+            const unsigned char escaped = (unsigned char)line[i++];
+            if (escaped != '\t' && (escaped < 0x20 || escaped == 0x7F))
+                return 0;
+
+            continue;
+        }
+
+        /* qdtext = HTAB / SP / %x21 / %x23-5B / %x5D-7E / obs-text */
+        if (c != '\t' && (c < 0x20 || c == 0x7F))
+            return 0;
+    }
+
+    return 0;
+}
+
+/**
+ * @private
+ * Gets the next complete line (without its line ending). <p>
+ * Lines that lie entirely within the input are returned in place; only a line that's split across two inputs is copied into the decoder's line buffer.
+ * @return <code>1</code> if a line was found; <code>0</code> if the input ended mid-line (the partial line is buffered); <code>-1</code> if the line is too long.
+ */
+static int next_line(struct glitchedhttps_chunked_decoder* decoder, const char* data, const size_t length, size_t* position, const char** line, size_t* line_length)
+{
+    const char* begin = data + *position;
+    const size_t available = length - *position;
+    const char* lf = memchr(begin, '\n', available);
+
+    if (lf == NULL)
+    {
+        if (decoder->line_length + available > sizeof(decoder->line))
+            return -1;
+
+        memcpy(decoder->line + decoder->line_length, begin, available);
+        decoder->line_length += available;
+        *position = length;
+        return 0;
+    }
+
+    const size_t n = lf - begin;
+    *position += n + 1;
+
+    if (decoder->line_length == 0)
+    {
+        *line = begin;
+        *line_length = n;
+    }
+    else
+    {
+        if (decoder->line_length + n > sizeof(decoder->line))
+            return -1;
+
+        memcpy(decoder->line + decoder->line_length, begin, n);
+        *line = decoder->line;
+        *line_length = decoder->line_length + n;
+        decoder->line_length = 0;
+    }
+
+    if (*line_length > 0 && (*line)[*line_length - 1] == '\r')
+    {
+        --(*line_length);
+    }
+
+    return 1;
+}
+
+/** @private */
+static int parse_chunk_size_line(struct glitchedhttps_chunked_decoder* decoder, const char* line, const size_t line_length)
+{
+    size_t i = 0, size = 0;
+
+    for (; i < line_length; ++i)
+    {
+        const char c = line[i];
+        const int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+
+        if (digit < 0)
+            break;
+
+        if (size > (SIZE_MAX >> 4))
+        {
+            glitchedhttps_log_error("Chunk size overflow!", __func__);
+            return GLITCHEDHTTPS_OVERFLOW;
+        }
+
+        size = (size << 4) | (size_t)digit;
+    }
+
+    if (i == 0)
+    {
+        glitchedhttps_log_error("Invalid chunk size line: no hex digits found!", __func__);
+        return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+    }
+
+    /*
+     * Chunk extensions (RFC 9112, section 7.1.1): *( BWS ";" BWS ext-name [ BWS "=" BWS ext-val ] ) with ext-val = token / quoted-string.
+     * They're validated but discarded: nothing uses them, and passing them on would let a server pile up as many of them as it likes (one per chunk).
+     */
+    while (i < line_length)
+    {
+        if (is_whitespace(line[i]))
+        {
+            ++i;
+            continue;
+        }
+
+        if (line[i] != ';')
+        {
+            glitchedhttps_log_error("Invalid chunk size line: unexpected character after chunk size!", __func__);
+            return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+        }
+
+        for (++i; i < line_length && is_whitespace(line[i]); ++i)
+            ;
+
+        const size_t name_length = skip_token(line, line_length, i);
+        if (name_length == 0)
+        {
+            glitchedhttps_log_error("Invalid chunk extension: missing extension name!", __func__);
+            return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+        }
+
+        i += name_length;
+
+        size_t j = i;
+        while (j < line_length && is_whitespace(line[j]))
+        {
+            ++j;
+        }
+
+        if (j == line_length || line[j] != '=')
+        {
+            /* No value: the whitespace in between is skipped by the next iteration. */
+            continue;
+        }
+
+        for (++j; j < line_length && is_whitespace(line[j]); ++j)
+            ;
+
+        const size_t value_length = j < line_length && line[j] == '"' ? skip_quoted_string(line, line_length, j) : skip_token(line, line_length, j);
+        if (value_length == 0)
+        {
+            glitchedhttps_log_error("Invalid chunk extension: missing or malformed extension value!", __func__);
+            return GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+        }
+
+        i = j + value_length;
+    }
+
+    decoder->chunk_remaining = size;
+    decoder->state = size > 0 ? GLITCHEDHTTPS_CHUNKED_STATE_DATA : GLITCHEDHTTPS_CHUNKED_STATE_TRAILER;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int parse_trailer_line(struct glitchedhttps_chunked_decoder* decoder, const char* line, const size_t line_length)
+{
+    if (line_length == 0)
+    {
+        decoder->state = GLITCHEDHTTPS_CHUNKED_STATE_DONE;
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    const char* colon = memchr(line, ':', line_length);
+    if (colon == NULL || colon == line)
+    {
+        /* Not a field line: ignore it. */
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    const char* value = colon + 1;
+    size_t value_length = line_length - (value - line);
+    trim(&value, &value_length);
+
+    if (decoder->on_header == NULL)
+        return GLITCHEDHTTPS_SUCCESS;
+
+    return decoder->on_header(decoder->on_header_ctx, line, colon - line, value, value_length);
+}
+
+int glitchedhttps_chunked_decode(struct glitchedhttps_chunked_decoder* decoder, char* data, const size_t length, size_t* out_length)
+{
+    if (decoder == NULL || out_length == NULL || (data == NULL && length > 0))
+    {
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    size_t position = 0, out = 0;
+    int r = GLITCHEDHTTPS_SUCCESS;
+
+    while (position < length && decoder->state != GLITCHEDHTTPS_CHUNKED_STATE_DONE)
+    {
+        switch (decoder->state)
+        {
+            case GLITCHEDHTTPS_CHUNKED_STATE_DATA: {
+                size_t n = length - position;
+                if (n > decoder->chunk_remaining)
+                    n = decoder->chunk_remaining;
+
+                if (out != position)
+                    memmove(data + out, data + position, n);
+
+                out += n;
+                position += n;
+                decoder->chunk_remaining -= n;
+
+                if (decoder->chunk_remaining == 0)
+                    decoder->state = GLITCHEDHTTPS_CHUNKED_STATE_DATA_CR;
+                break;
+            }
+            case GLITCHEDHTTPS_CHUNKED_STATE_DATA_CR:
+                /* Be lenient and also accept a bare LF after the chunk data. */
+                if (data[position] == '\r')
+                    ++position;
+                decoder->state = GLITCHEDHTTPS_CHUNKED_STATE_DATA_LF;
+                break;
+            case GLITCHEDHTTPS_CHUNKED_STATE_DATA_LF:
+                if (data[position++] != '\n')
+                {
+                    glitchedhttps_log_error("Chunk data not terminated by CRLF!", __func__);
+                    r = GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+                    goto exit;
+                }
+                decoder->state = GLITCHEDHTTPS_CHUNKED_STATE_SIZE;
+                break;
+            case GLITCHEDHTTPS_CHUNKED_STATE_SIZE:
+            case GLITCHEDHTTPS_CHUNKED_STATE_TRAILER: {
+                const char* line = NULL;
+                size_t line_length = 0;
+
+                const int found = next_line(decoder, data, length, &position, &line, &line_length);
+                if (found < 0)
+                {
+                    glitchedhttps_log_error("Chunk size or trailer line too long!", __func__);
+                    r = GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+                    goto exit;
+                }
+
+                if (found == 0)
+                    break;
+
+                r = decoder->state == GLITCHEDHTTPS_CHUNKED_STATE_SIZE ? parse_chunk_size_line(decoder, line, line_length) : parse_trailer_line(decoder, line, line_length);
+                if (r != GLITCHEDHTTPS_SUCCESS)
+                    goto exit;
+                break;
+            }
+            default:
+                r = GLITCHEDHTTPS_RESPONSE_PARSE_ERROR;
+                goto exit;
+        }
+    }
+
+exit:
+    *out_length = out;
+    return r;
+}
+
+#undef GLITCHEDHTTPS_CHUNKED_STATE_SIZE
+#undef GLITCHEDHTTPS_CHUNKED_STATE_DATA
+#undef GLITCHEDHTTPS_CHUNKED_STATE_DATA_CR
+#undef GLITCHEDHTTPS_CHUNKED_STATE_DATA_LF
+#undef GLITCHEDHTTPS_CHUNKED_STATE_TRAILER
+#undef GLITCHEDHTTPS_CHUNKED_STATE_DONE
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,326 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_decoder.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_strutil.h"
+#include "glitchedhttps_debug.h"
+#include <string.h>
+
+static const struct glitchedhttps_content_decoder* registered_decoders[GLITCHEDHTTPS_MAX_CONTENT_DECODERS];
+static size_t registered_decoders_count = 0;
+
+/** @private The built-in decoders, in order of preference (that's also the order in which they're listed in the Accept-Encoding header). */
+static const struct glitchedhttps_content_decoder* const builtin_decoders[] = {
+#ifdef GLITCHEDHTTPS_ENABLE_ZSTD
+    &glitchedhttps_zstd_decoder,
+#endif
+#ifdef GLITCHEDHTTPS_ENABLE_BROTLI
+    &glitchedhttps_brotli_decoder,
+#endif
+#ifdef GLITCHEDHTTPS_ENABLE_ZLIB
+    &glitchedhttps_gzip_decoder,
+    &glitchedhttps_deflate_decoder,
+#endif
+    NULL
+};
+
+/** @private */
+static const size_t builtin_decoders_count = sizeof(builtin_decoders) / sizeof(builtin_decoders[0]) - 1;
+
+/** @private */
+static int name_equals(const struct glitchedhttps_content_decoder* decoder, const char* name, const size_t name_length)
+{
+    return strlen(decoder->name) == name_length && glitchedhttps_strnequalic(decoder->name, name, name_length);
+}
+
+int glitchedhttps_register_content_decoder(const struct glitchedhttps_content_decoder* decoder)
+{
+    if (decoder == NULL)
+    {
+        glitchedhttps_log_error("Content decoder NULL!", __func__);
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    if (decoder->name == NULL || *decoder->name == '\0' || decoder->init == NULL || decoder->update == NULL || decoder->finish == NULL || decoder->free == NULL)
+    {
+        glitchedhttps_log_error("Incomplete content decoder: it needs a name and all four functions!", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    const size_t name_length = strlen(decoder->name);
+
+    for (size_t i = 0; i < registered_decoders_count; ++i)
+    {
+        if (name_equals(registered_decoders[i], decoder->name, name_length))
+        {
+            registered_decoders[i] = decoder;
+            return GLITCHEDHTTPS_SUCCESS;
+        }
+    }
+
+    if (registered_decoders_count == GLITCHEDHTTPS_MAX_CONTENT_DECODERS)
+    {
+        glitchedhttps_log_error("Too many content decoders registered!", __func__);
+        return GLITCHEDHTTPS_OVERFLOW;
+    }
+
+    registered_decoders[registered_decoders_count++] = decoder;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+const struct glitchedhttps_content_decoder* glitchedhttps_find_content_decoder(const char* name, size_t name_length)
+{
+    if (name == NULL || name_length == 0)
+    {
+        return NULL;
+    }
+
+    /* "x-gzip" is an old alias of "gzip" that servers may still send. */
+    if (name_length == 6 && glitchedhttps_strnequalic(name, "x-gzip", 6))
+    {
+        name += 2;
+        name_length -= 2;
+    }
+
+    for (size_t i = 0; i < registered_decoders_count; ++i)
+    {
+        if (name_equals(registered_decoders[i], name, name_length))
+        {
+            return registered_decoders[i];
+        }
+    }
+
+    for (size_t i = 0; i < builtin_decoders_count; ++i)
+    {
+        if (name_equals(builtin_decoders[i], name, name_length))
+        {
+            return builtin_decoders[i];
+        }
+    }
+
+    return NULL;
+}
+
+/** @private */
+static int append_coding(char* out, const size_t out_size, size_t* length, const char* name)
+{
+    const size_t name_length = strlen(name);
+
+    /* Skip built-in decoders that were overridden by a registered one. */
+    for (size_t i = 0; i < *length;)
+    {
+        const char* end = memchr(out + i, ',', *length - i);
+        const size_t n = (end != NULL ? (size_t)(end - out) : *length) - i;
+
+        if (n == name_length && glitchedhttps_strnequalic(out + i, name, n))
+            return 1;
+
+        i += n + 2;
+    }
+
+    const size_t separator_length = *length > 0 ? 2 : 0;
+    if (*length + separator_length + name_length + 1 > out_size)
+    {
+        return 0;
+    }
+
+    memcpy(out + *length, ", ", separator_length);
+    memcpy(out + *length + separator_length, name, name_length);
+    *length += separator_length + name_length;
+    out[*length] = '\0';
+    return 1;
+}
+
+size_t glitchedhttps_get_accept_encoding(char* out, const size_t out_size)
+{
+    if (out == NULL || out_size == 0)
+    {
+        return 0;
+    }
+
+    size_t length = 0;
+    out[0] = '\0';
+
+    for (size_t i = 0; i < registered_decoders_count; ++i)
+    {
+        if (!append_coding(out, out_size, &length, registered_decoders[i]->name))
+            goto too_small;
+    }
+
+    for (size_t i = 0; i < builtin_decoders_count; ++i)
+    {
+        if (!append_coding(out, out_size, &length, builtin_decoders[i]->name))
+            goto too_small;
+    }
+
+    return length;
+
+too_small:
+    glitchedhttps_log_error("Buffer too small for the Accept-Encoding header value!", __func__);
+    out[0] = '\0';
+    return 0;
+}
+
+/** @private */
+static int feed(struct glitchedhttps_decoding_pipeline* pipeline, size_t index, const char* data, size_t length);
+
+/** @private Output callback of a pipeline stage: passes the stage's output on to the next stage. */
+static int stage_output(void* ctx, const char* data, const size_t length)
+{
+    const struct glitchedhttps_decoding_stage* stage = (const struct glitchedhttps_decoding_stage*)ctx;
+    return feed(stage->pipeline, stage->index + 1, data, length);
+}
+
+static int feed(struct glitchedhttps_decoding_pipeline* pipeline, const size_t index, const char* data, const size_t length)
+{
+    if (length == 0)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    if (index == pipeline->count)
+    {
+        return pipeline->output(pipeline->output_ctx, data, length);
+    }
+
+    struct glitchedhttps_decoding_stage* stage = &pipeline->stages[index];
+    return stage->decoder->update(stage->state, data, length, &stage_output, stage);
+}
+
+int glitchedhttps_decoding_pipeline_init(struct glitchedhttps_decoding_pipeline* pipeline, const char* content_encoding, size_t content_encoding_length, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    if (pipeline == NULL || output == NULL)
+    {
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    memset(pipeline, 0x00, sizeof(struct glitchedhttps_decoding_pipeline));
+    pipeline->output = output;
+    pipeline->output_ctx = output_ctx;
+
+    if (content_encoding == NULL)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    /* The codings are listed in the order in which they were applied: decode them back to front. */
+    const char* end = content_encoding + content_encoding_length;
+
+    while (end > content_encoding)
+    {
+        const char* begin = end;
+        while (begin > content_encoding && begin[-1] != ',')
+            --begin;
+
+        const char* coding = begin;
+        size_t coding_length = end - begin;
+
+        while (coding_length > 0 && (*coding == ' ' || *coding == '\t'))
+        {
+            ++coding;
+            --coding_length;
+        }
+
+        while (coding_length > 0 && (coding[coding_length - 1] == ' ' || coding[coding_length - 1] == '\t'))
+        {
+            --coding_length;
+        }
+
+        end = begin > content_encoding ? begin - 1 : begin;
+
+        if (coding_length == 0 || (coding_length == 8 && glitchedhttps_strnequalic(coding, "identity", 8)))
+        {
+            continue;
+        }
+
+        const struct glitchedhttps_content_decoder* decoder = glitchedhttps_find_content_decoder(coding, coding_length);
+        if (decoder == NULL || pipeline->count == GLITCHEDHTTPS_MAX_CONTENT_CODINGS)
+        {
+            glitchedhttps_decoding_pipeline_free(pipeline);
+            return GLITCHEDHTTPS_INVALID_ARG;
+        }
+
+        struct glitchedhttps_decoding_stage* stage = &pipeline->stages[pipeline->count];
+
+        const int r = decoder->init(&stage->state);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            glitchedhttps_log_error("Content decoder initialization failed!", __func__);
+            glitchedhttps_decoding_pipeline_free(pipeline);
+            return r;
+        }
+
+        stage->decoder = decoder;
+        stage->pipeline = pipeline;
+        stage->index = pipeline->count++;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+int glitchedhttps_decoding_pipeline_update(struct glitchedhttps_decoding_pipeline* pipeline, const char* data, const size_t length)
+{
+    if (pipeline == NULL || (data == NULL && length > 0))
+    {
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    return feed(pipeline, 0, data, length);
+}
+
+int glitchedhttps_decoding_pipeline_finish(struct glitchedhttps_decoding_pipeline* pipeline)
+{
+    if (pipeline == NULL)
+    {
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    /* Finish front to back, so that whatever a stage flushes still runs through all of the stages after it before those finish. */
+    for (size_t i = 0; i < pipeline->count; ++i)
+    {
+        struct glitchedhttps_decoding_stage* stage = &pipeline->stages[i];
+
+        const int r = stage->decoder->finish(stage->state, &stage_output, stage);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+void glitchedhttps_decoding_pipeline_free(struct glitchedhttps_decoding_pipeline* pipeline)
+{
+    if (pipeline == NULL)
+        return;
+
+    for (size_t i = 0; i < pipeline->count; ++i)
+    {
+        pipeline->stages[i].decoder->free(pipeline->stages[i].state);
+    }
+
+    memset(pipeline, 0x00, sizeof(struct glitchedhttps_decoding_pipeline));
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
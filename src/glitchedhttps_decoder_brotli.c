@@ -0,0 +1,112 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef GLITCHEDHTTPS_ENABLE_BROTLI
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_decoder.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include <brotli/decode.h>
+
+/** @private */
+static int init(void** state)
+{
+    BrotliDecoderState* s = BrotliDecoderCreateInstance(NULL, NULL, NULL);
+    if (s == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    *state = s;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int update(void* state, const char* data, const size_t length, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    BrotliDecoderState* s = (BrotliDecoderState*)state;
+
+    const uint8_t* next_in = (const uint8_t*)data;
+    size_t available_in = length;
+
+    uint8_t out[GLITCHEDHTTPS_DECODER_CHUNK_SIZE];
+
+    for (;;)
+    {
+        uint8_t* next_out = out;
+        size_t available_out = sizeof(out);
+
+        const BrotliDecoderResult r = BrotliDecoderDecompressStream(s, &available_in, &next_in, &available_out, &next_out, NULL);
+        if (r == BROTLI_DECODER_RESULT_ERROR)
+        {
+            glitchedhttps_log_error("Response body decompression failed: invalid brotli data!", __func__);
+            return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+        }
+
+        const size_t produced = sizeof(out) - available_out;
+        if (produced > 0)
+        {
+            const int o = output(output_ctx, (const char*)out, produced);
+            if (o != GLITCHEDHTTPS_SUCCESS)
+            {
+                return o;
+            }
+        }
+
+        /* Anything after the end of the compressed stream is ignored. */
+        if (r != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT)
+        {
+            return GLITCHEDHTTPS_SUCCESS;
+        }
+    }
+}
+
+/** @private */
+static int finish(void* state, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    (void)output;
+    (void)output_ctx;
+
+    if (!BrotliDecoderIsFinished((const BrotliDecoderState*)state) && BrotliDecoderIsUsed((const BrotliDecoderState*)state))
+    {
+        glitchedhttps_log_error("Response body decompression failed: the brotli data is truncated!", __func__);
+        return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static void free_state(void* state)
+{
+    if (state != NULL)
+    {
+        BrotliDecoderDestroyInstance((BrotliDecoderState*)state);
+    }
+}
+
+const struct glitchedhttps_content_decoder glitchedhttps_brotli_decoder = { "br", &init, &update, &finish, &free_state };
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_ENABLE_BROTLI
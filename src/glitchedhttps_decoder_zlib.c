@@ -0,0 +1,217 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef GLITCHEDHTTPS_ENABLE_ZLIB
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_decoder.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include <stdlib.h>
+#include <limits.h>
+#include <zlib.h>
+
+/** @private */
+struct zlib_state
+{
+    z_stream stream;
+    int gzip;
+    int started;
+
+    /** At the end of a gzip member (more members may still follow) or of the deflate stream. */
+    int finished;
+};
+
+/** @private */
+static int init(void** state, const int gzip)
+{
+    struct zlib_state* s = calloc(1, sizeof(struct zlib_state));
+    if (s == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    s->gzip = gzip;
+    *state = s;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int init_gzip(void** state)
+{
+    return init(state, 1);
+}
+
+/** @private */
+static int init_deflate(void** state)
+{
+    return init(state, 0);
+}
+
+/**
+ * @private
+ * Sets up the zlib stream once the first byte of the compressed body is known. <p>
+ * HTTP's "deflate" is supposed to be zlib-wrapped (RFC 1950), but quite a few servers send raw deflate data (RFC 1951) instead:
+ * a zlib header always starts with a byte whose lower nibble is 8 (the "deflate" compression method), which tells the two apart.
+ */
+static int start(struct zlib_state* s, const unsigned char first_byte)
+{
+    const int window_bits = s->gzip ? 15 + 16 : (first_byte & 0x0F) == 8 ? 15 : -15;
+
+    if (inflateInit2(&s->stream, window_bits) != Z_OK)
+    {
+        glitchedhttps_log_error("\"inflateInit2\" failed!", __func__);
+        return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+    }
+
+    s->started = 1;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private Inflates at most <code>UINT_MAX</code> bytes of input (zlib counts its input in an unsigned int). */
+static int inflate_slice(struct zlib_state* s, const char* data, const size_t length, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    unsigned char out[GLITCHEDHTTPS_DECODER_CHUNK_SIZE];
+
+    s->stream.next_in = (unsigned char*)data;
+    s->stream.avail_in = (uInt)length;
+
+    while (s->stream.avail_in > 0)
+    {
+        if (s->finished)
+        {
+            /* gzip bodies may consist of several concatenated members (which can start in any later read). */
+            if (inflateReset(&s->stream) != Z_OK)
+            {
+                glitchedhttps_log_error("\"inflateReset\" failed!", __func__);
+                return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+            }
+
+            s->finished = 0;
+        }
+
+        s->stream.next_out = out;
+        s->stream.avail_out = sizeof(out);
+
+        const int r = inflate(&s->stream, Z_NO_FLUSH);
+        if (r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR)
+        {
+            glitchedhttps_log_error("Response body decompression failed: invalid compressed data!", __func__);
+            return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+        }
+
+        const size_t produced = sizeof(out) - s->stream.avail_out;
+        if (produced > 0)
+        {
+            const int o = output(output_ctx, (const char*)out, produced);
+            if (o != GLITCHEDHTTPS_SUCCESS)
+            {
+                return o;
+            }
+        }
+
+        if (r == Z_STREAM_END)
+        {
+            s->finished = 1;
+
+            if (!s->gzip)
+                break;
+
+            continue;
+        }
+
+        if (r == Z_BUF_ERROR && produced == 0)
+        {
+            break;
+        }
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int update(void* state, const char* data, size_t length, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    struct zlib_state* s = (struct zlib_state*)state;
+
+    if (length > 0 && !s->started && start(s, (unsigned char)data[0]) != GLITCHEDHTTPS_SUCCESS)
+    {
+        return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+    }
+
+    /* Anything after the end of the deflate stream is ignored. Buffered bodies arrive here in one piece: those of 4 GiB and more are inflated in slices. */
+    while (length > 0 && !(s->finished && !s->gzip))
+    {
+        const size_t slice = length > UINT_MAX ? UINT_MAX : length;
+
+        const int r = inflate_slice(s, data, slice, output, output_ctx);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+
+        data += slice;
+        length -= slice;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int finish(void* state, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    (void)output;
+    (void)output_ctx;
+
+    const struct zlib_state* s = (const struct zlib_state*)state;
+
+    if (s->started && !s->finished)
+    {
+        glitchedhttps_log_error("Response body decompression failed: the compressed data is truncated!", __func__);
+        return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static void free_state(void* state)
+{
+    struct zlib_state* s = (struct zlib_state*)state;
+    if (s == NULL)
+        return;
+
+    if (s->started)
+    {
+        inflateEnd(&s->stream);
+    }
+
+    free(s);
+}
+
+const struct glitchedhttps_content_decoder glitchedhttps_gzip_decoder = { "gzip", &init_gzip, &update, &finish, &free_state };
+
+const struct glitchedhttps_content_decoder glitchedhttps_deflate_decoder = { "deflate", &init_deflate, &update, &finish, &free_state };
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_ENABLE_ZLIB
@@ -0,0 +1,147 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef GLITCHEDHTTPS_ENABLE_ZSTD
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_decoder.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include <stdlib.h>
+#include <zstd.h>
+
+/** @private */
+struct zstd_state
+{
+    ZSTD_DStream* stream;
+
+    /** Whether the last frame is incomplete (i.e. more input is needed to finish it). */
+    int in_frame;
+};
+
+/** @private */
+static int init(void** state)
+{
+    struct zstd_state* s = calloc(1, sizeof(struct zstd_state));
+    if (s == NULL || (s->stream = ZSTD_createDStream()) == NULL)
+    {
+        free(s);
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    *state = s;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int update(void* state, const char* data, const size_t length, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    struct zstd_state* s = (struct zstd_state*)state;
+
+    char out[GLITCHEDHTTPS_DECODER_CHUNK_SIZE];
+    ZSTD_inBuffer in = { data, length, 0 };
+
+    ZSTD_outBuffer o = { out, sizeof(out), sizeof(out) };
+
+    /* Keep going while there's input left, or while the output buffer was filled up completely (more output might be pending). */
+    while (in.pos < in.size || o.pos == o.size)
+    {
+        o.pos = 0;
+
+        /* A return value of 0 means that a frame was completely decoded and flushed (a body can consist of several frames). */
+        const size_t r = ZSTD_decompressStream(s->stream, &o, &in);
+        if (ZSTD_isError(r))
+        {
+            glitchedhttps_log_error("Response body decompression failed: invalid zstd data!", __func__);
+            return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+        }
+
+        s->in_frame = r != 0;
+
+        if (o.pos > 0)
+        {
+            const int e = output(output_ctx, out, o.pos);
+            if (e != GLITCHEDHTTPS_SUCCESS)
+            {
+                return e;
+            }
+        }
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int finish(void* state, glitchedhttps_decoder_output_callback output, void* output_ctx)
+{
+    struct zstd_state* s = (struct zstd_state*)state;
+
+    /* Flush whatever's still buffered inside the decoder. */
+    char out[GLITCHEDHTTPS_DECODER_CHUNK_SIZE];
+    while (s->in_frame)
+    {
+        ZSTD_inBuffer in = { NULL, 0, 0 };
+        ZSTD_outBuffer o = { out, sizeof(out), 0 };
+
+        const size_t r = ZSTD_decompressStream(s->stream, &o, &in);
+        if (ZSTD_isError(r))
+        {
+            return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+        }
+
+        if (o.pos > 0)
+        {
+            const int e = output(output_ctx, out, o.pos);
+            if (e != GLITCHEDHTTPS_SUCCESS)
+            {
+                return e;
+            }
+        }
+
+        s->in_frame = r != 0;
+
+        if (s->in_frame && o.pos == 0)
+        {
+            glitchedhttps_log_error("Response body decompression failed: the zstd data is truncated!", __func__);
+            return GLITCHEDHTTPS_DECOMPRESSION_FAILED;
+        }
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static void free_state(void* state)
+{
+    struct zstd_state* s = (struct zstd_state*)state;
+    if (s == NULL)
+        return;
+
+    ZSTD_freeDStream(s->stream);
+    free(s);
+}
+
+const struct glitchedhttps_content_decoder glitchedhttps_zstd_decoder = { "zstd", &init, &update, &finish, &free_state };
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // GLITCHEDHTTPS_ENABLE_ZSTD
@@ -0,0 +1,220 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_encoder.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include <stdlib.h>
+#include <limits.h>
+
+#ifdef GLITCHEDHTTPS_ENABLE_ZLIB
+#include <zlib.h>
+
+/** @private */
+static int gzip_init(void** state)
+{
+    z_stream* stream = calloc(1, sizeof(z_stream));
+    if (stream == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    /* 15 + 16 window bits: write a gzip header and trailer around the deflate data. */
+    if (deflateInit2(stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        glitchedhttps_log_error("\"deflateInit2\" failed!", __func__);
+        free(stream);
+        return GLITCHEDHTTPS_EXTERNAL_ERROR;
+    }
+
+    *state = stream;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int gzip_deflate(z_stream* stream, const char* data, const size_t length, const int flush, glitchedhttps_encoder_output_callback output, void* output_ctx)
+{
+    unsigned char out[GLITCHEDHTTPS_ENCODER_CHUNK_SIZE];
+
+    stream->next_in = (unsigned char*)data;
+    stream->avail_in = (uInt)length;
+
+    int r;
+    do
+    {
+        stream->next_out = out;
+        stream->avail_out = sizeof(out);
+
+        r = deflate(stream, flush);
+        if (r == Z_STREAM_ERROR)
+        {
+            glitchedhttps_log_error("\"deflate\" failed!", __func__);
+            return GLITCHEDHTTPS_EXTERNAL_ERROR;
+        }
+
+        const size_t produced = sizeof(out) - stream->avail_out;
+        if (produced > 0)
+        {
+            const int o = output(output_ctx, (const char*)out, produced);
+            if (o != GLITCHEDHTTPS_SUCCESS)
+            {
+                return o;
+            }
+        }
+    } while (stream->avail_out == 0 || (flush == Z_FINISH && r != Z_STREAM_END));
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int gzip_update(void* state, const char* data, size_t length, glitchedhttps_encoder_output_callback output, void* output_ctx)
+{
+    /* zlib counts its input in an unsigned int: in-memory bodies of 4 GiB and more are fed to it in slices. */
+    while (length > 0)
+    {
+        const size_t slice = length > UINT_MAX ? UINT_MAX : length;
+
+        const int r = gzip_deflate((z_stream*)state, data, slice, Z_NO_FLUSH, output, output_ctx);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+
+        data += slice;
+        length -= slice;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int gzip_finish(void* state, glitchedhttps_encoder_output_callback output, void* output_ctx)
+{
+    return gzip_deflate((z_stream*)state, NULL, 0, Z_FINISH, output, output_ctx);
+}
+
+/** @private */
+static void gzip_free(void* state)
+{
+    if (state != NULL)
+    {
+        deflateEnd((z_stream*)state);
+        free(state);
+    }
+}
+
+/** @private */
+static const struct glitchedhttps_content_encoder gzip_encoder = { "gzip", &gzip_init, &gzip_update, &gzip_finish, &gzip_free };
+
+#endif // GLITCHEDHTTPS_ENABLE_ZLIB
+
+#ifdef GLITCHEDHTTPS_ENABLE_ZSTD
+#include <zstd.h>
+
+/** @private */
+static int zstd_init(void** state)
+{
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    if (cctx == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    *state = cctx;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int zstd_compress(ZSTD_CCtx* cctx, const char* data, const size_t length, const ZSTD_EndDirective mode, glitchedhttps_encoder_output_callback output, void* output_ctx)
+{
+    char out[GLITCHEDHTTPS_ENCODER_CHUNK_SIZE];
+    ZSTD_inBuffer in = { data, length, 0 };
+
+    size_t remaining;
+    do
+    {
+        ZSTD_outBuffer o = { out, sizeof(out), 0 };
+
+        /* With ZSTD_e_continue this returns as soon as all input was consumed; with ZSTD_e_end, once the frame was completely flushed (0 bytes remaining). */
+        remaining = ZSTD_compressStream2(cctx, &o, &in, mode);
+        if (ZSTD_isError(remaining))
+        {
+            glitchedhttps_log_error("\"ZSTD_compressStream2\" failed!", __func__);
+            return GLITCHEDHTTPS_EXTERNAL_ERROR;
+        }
+
+        if (o.pos > 0)
+        {
+            const int r = output(output_ctx, out, o.pos);
+            if (r != GLITCHEDHTTPS_SUCCESS)
+            {
+                return r;
+            }
+        }
+    } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/** @private */
+static int zstd_update(void* state, const char* data, const size_t length, glitchedhttps_encoder_output_callback output, void* output_ctx)
+{
+    return length == 0 ? GLITCHEDHTTPS_SUCCESS : zstd_compress((ZSTD_CCtx*)state, data, length, ZSTD_e_continue, output, output_ctx);
+}
+
+/** @private */
+static int zstd_finish(void* state, glitchedhttps_encoder_output_callback output, void* output_ctx)
+{
+    return zstd_compress((ZSTD_CCtx*)state, NULL, 0, ZSTD_e_end, output, output_ctx);
+}
+
+/** @private */
+static void zstd_free(void* state)
+{
+    ZSTD_freeCCtx((ZSTD_CCtx*)state);
+}
+
+/** @private */
+static const struct glitchedhttps_content_encoder zstd_encoder = { "zstd", &zstd_init, &zstd_update, &zstd_finish, &zstd_free };
+
+#endif // GLITCHEDHTTPS_ENABLE_ZSTD
+
+const struct glitchedhttps_content_encoder* glitchedhttps_get_content_encoder(const enum glitchedhttps_content_coding coding)
+{
+    switch (coding)
+    {
+#ifdef GLITCHEDHTTPS_ENABLE_ZLIB
+        case GLITCHEDHTTPS_CODING_GZIP:
+            return &gzip_encoder;
+#endif
+#ifdef GLITCHEDHTTPS_ENABLE_ZSTD
+        case GLITCHEDHTTPS_CODING_ZSTD:
+            return &zstd_encoder;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -20,7 +20,10 @@ extern "C" {
 
 #include "glitchedhttps_debug.h"
 #include "glitchedhttps_header.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_strutil.h"
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 struct glitchedhttps_header* glitchedhttps_header_init(const char* type, const size_t type_length, const char* value, const size_t value_length)
@@ -50,9 +53,13 @@ struct glitchedhttps_header* glitchedhttps_header_init(const char* type, const s
     if (out->type == NULL || out->value == NULL)
     {
         glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        glitchedhttps_header_free(out);
         return NULL;
     }
 
+    out->type_length = type_length;
+    out->value_length = value_length;
+
     memcpy(out->type, type, type_length);
     out->type[type_length] = '\0';
 
@@ -69,6 +76,76 @@ struct glitchedhttps_header* glitchedhttps_header_init(const char* type, const s
     return out;
 }
 
+/** @private Lowercase names of the well-known headers, indexed by their glitchedhttps_header_name. */
+static const char* const well_known_header_names[] = {
+    [GLITCHEDHTTPS_HEADER_UNKNOWN] = NULL,
+    [GLITCHEDHTTPS_HEADER_SERVER] = "server",
+    [GLITCHEDHTTPS_HEADER_DATE] = "date",
+    [GLITCHEDHTTPS_HEADER_CONTENT_TYPE] = "content-type",
+    [GLITCHEDHTTPS_HEADER_CONTENT_ENCODING] = "content-encoding",
+    [GLITCHEDHTTPS_HEADER_CONTENT_LENGTH] = "content-length",
+    [GLITCHEDHTTPS_HEADER_TRANSFER_ENCODING] = "transfer-encoding",
+    [GLITCHEDHTTPS_HEADER_CONNECTION] = "connection",
+    [GLITCHEDHTTPS_HEADER_KEEP_ALIVE] = "keep-alive",
+    [GLITCHEDHTTPS_HEADER_ETAG] = "etag",
+    [GLITCHEDHTTPS_HEADER_CACHE_CONTROL] = "cache-control",
+    [GLITCHEDHTTPS_HEADER_LOCATION] = "location",
+};
+
+enum glitchedhttps_header_name glitchedhttps_header_lookup(const char* name, const size_t name_length)
+{
+    if (name == NULL || name_length == 0)
+    {
+        return GLITCHEDHTTPS_HEADER_UNKNOWN;
+    }
+
+    /* (length, first character) is unique across the well-known header names. */
+    enum glitchedhttps_header_name candidate = GLITCHEDHTTPS_HEADER_UNKNOWN;
+    const char first = glitchedhttps_tolower_ascii(name[0]);
+
+    switch (name_length)
+    {
+        case 4:
+            candidate = first == 'd' ? GLITCHEDHTTPS_HEADER_DATE : first == 'e' ? GLITCHEDHTTPS_HEADER_ETAG : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 6:
+            candidate = first == 's' ? GLITCHEDHTTPS_HEADER_SERVER : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 8:
+            candidate = first == 'l' ? GLITCHEDHTTPS_HEADER_LOCATION : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 10:
+            candidate = first == 'c' ? GLITCHEDHTTPS_HEADER_CONNECTION : first == 'k' ? GLITCHEDHTTPS_HEADER_KEEP_ALIVE : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 12:
+            candidate = first == 'c' ? GLITCHEDHTTPS_HEADER_CONTENT_TYPE : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 13:
+            candidate = first == 'c' ? GLITCHEDHTTPS_HEADER_CACHE_CONTROL : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 14:
+            candidate = first == 'c' ? GLITCHEDHTTPS_HEADER_CONTENT_LENGTH : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 16:
+            candidate = first == 'c' ? GLITCHEDHTTPS_HEADER_CONTENT_ENCODING : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        case 17:
+            candidate = first == 't' ? GLITCHEDHTTPS_HEADER_TRANSFER_ENCODING : GLITCHEDHTTPS_HEADER_UNKNOWN;
+            break;
+        default:
+            break;
+    }
+
+    /* The full comparison also catches a switch entry that doesn't agree with the name table. */
+    const char* candidate_name = well_known_header_names[candidate];
+    if (candidate_name == NULL || strlen(candidate_name) != name_length || !glitchedhttps_strnequalic(name, candidate_name, name_length))
+    {
+        return GLITCHEDHTTPS_HEADER_UNKNOWN;
+    }
+
+    return candidate;
+}
+
 void glitchedhttps_header_free(struct glitchedhttps_header* header)
 {
     if (header != NULL)
@@ -79,6 +156,171 @@ void glitchedhttps_header_free(struct glitchedhttps_header* header)
     }
 }
 
+void glitchedhttps_header_list_init(struct glitchedhttps_header_list* list)
+{
+    if (list != NULL)
+    {
+        memset(list, 0x00, sizeof(struct glitchedhttps_header_list));
+    }
+}
+
+/**
+ * @private
+ * Grows the backing buffer of a header list to hold at least \p min_capacity bytes. <p>
+ * The strings are moved over to a new buffer (rather than realloc'ed) so that the headers' pointers can be rebased while the old buffer is still valid.
+ */
+static int grow_header_list_buffer(struct glitchedhttps_header_list* list, const size_t min_capacity)
+{
+    size_t capacity = list->buffer_capacity > 0 ? list->buffer_capacity : 256;
+    while (capacity < min_capacity)
+    {
+        capacity *= 2;
+    }
+
+    char* buffer = malloc(capacity);
+    if (buffer == NULL)
+    {
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    if (list->buffer_length > 0)
+    {
+        memcpy(buffer, list->buffer, list->buffer_length);
+    }
+
+    for (size_t i = 0; i < list->headers_count; ++i)
+    {
+        struct glitchedhttps_header* header = &list->headers[i];
+        header->type = buffer + (header->type - list->buffer);
+        header->value = buffer + (header->value - list->buffer);
+    }
+
+    free(list->buffer);
+    list->buffer = buffer;
+    list->buffer_capacity = capacity;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Checks whether a string lies inside the list's buffer (e.g. when an entry of the same list is added again) and if so, where.
+ * @return <code>1</code> if \p string points into the list's buffer (its offset is then written into \p offset); <code>0</code> if it doesn't.
+ */
+static int offset_in_buffer(const struct glitchedhttps_header_list* list, const char* string, size_t* offset)
+{
+    /* Compared as integers: relational operators on pointers into different objects are undefined. */
+    const uintptr_t begin = (uintptr_t)list->buffer;
+    const uintptr_t address = (uintptr_t)string;
+
+    if (list->buffer == NULL || address < begin || address >= begin + list->buffer_length)
+    {
+        return 0;
+    }
+
+    *offset = (size_t)(address - begin);
+    return 1;
+}
+
+int glitchedhttps_header_list_add(struct glitchedhttps_header_list* list, const char* type, size_t type_length, const char* value, size_t value_length)
+{
+    if (list == NULL || type == NULL || value == NULL)
+    {
+        glitchedhttps_log_error("Header list, type or value string NULL!", __func__);
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    if (type_length == 0)
+    {
+        type_length = strlen(type);
+    }
+
+    if (value_length == 0)
+    {
+        value_length = strlen(value);
+    }
+
+    if (type_length == 0)
+    {
+        glitchedhttps_log_error("Header type string empty!", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    if (list->headers_count == list->headers_capacity)
+    {
+        const size_t headers_capacity = list->headers_capacity > 0 ? list->headers_capacity * 2 : 8;
+
+        struct glitchedhttps_header* headers = realloc(list->headers, headers_capacity * sizeof(struct glitchedhttps_header));
+        if (headers == NULL)
+        {
+            glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+            return GLITCHEDHTTPS_OUT_OF_MEM;
+        }
+
+        list->headers = headers;
+        list->headers_capacity = headers_capacity;
+    }
+
+    const size_t required = list->buffer_length + type_length + value_length + 2;
+
+    if (required > list->buffer_capacity)
+    {
+        /* Growing frees the old buffer: strings that come out of it (e.g. from one of this list's own entries) need to follow it into the new one. */
+        size_t type_offset = 0, value_offset = 0;
+        const int type_in_buffer = offset_in_buffer(list, type, &type_offset);
+        const int value_in_buffer = offset_in_buffer(list, value, &value_offset);
+
+        if (grow_header_list_buffer(list, required) != GLITCHEDHTTPS_SUCCESS)
+        {
+            glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+            return GLITCHEDHTTPS_OUT_OF_MEM;
+        }
+
+        if (type_in_buffer)
+            type = list->buffer + type_offset;
+
+        if (value_in_buffer)
+            value = list->buffer + value_offset;
+    }
+
+    struct glitchedhttps_header* header = &list->headers[list->headers_count];
+
+    header->type = list->buffer + list->buffer_length;
+    header->type_length = type_length;
+    memcpy(header->type, type, type_length);
+    header->type[type_length] = '\0';
+
+    header->value = header->type + type_length + 1;
+    header->value_length = value_length;
+    if (value_length > 0)
+    {
+        memcpy(header->value, value, value_length);
+    }
+    header->value[value_length] = '\0';
+
+    list->buffer_length = required;
+    list->headers_count++;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+void glitchedhttps_header_list_clear(struct glitchedhttps_header_list* list)
+{
+    if (list != NULL)
+    {
+        list->headers_count = 0;
+        list->buffer_length = 0;
+    }
+}
+
+void glitchedhttps_header_list_free(struct glitchedhttps_header_list* list)
+{
+    if (list != NULL)
+    {
+        free(list->headers);
+        free(list->buffer);
+        memset(list, 0x00, sizeof(struct glitchedhttps_header_list));
+    }
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
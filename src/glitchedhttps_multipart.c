@@ -0,0 +1,577 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_multipart.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include "glitchedhttps_guid.h"
+#include <chillbuff.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#define GLITCHEDHTTPS_MULTIPART_STAGE_HEAD 0
+#define GLITCHEDHTTPS_MULTIPART_STAGE_DATA 1
+#define GLITCHEDHTTPS_MULTIPART_STAGE_CRLF 2
+
+/** @private */
+struct multipart_part
+{
+    /** The part's delimiter line and header section (up to and including the empty line). */
+    char* head;
+
+    /** Length of the {@link #head}. */
+    size_t head_length;
+
+    /** In-memory parts only: the (referenced) part content. */
+    const char* data;
+
+    /** The part content's length (for file parts: the file size at the time the part was added). */
+    size_t data_length;
+
+    /** File parts only: the path of the file to send (<code>NULL</code> for in-memory parts). */
+    char* path;
+};
+
+struct glitchedhttps_multipart
+{
+    /** The boundary (without the leading "--"). */
+    char boundary[64];
+
+    /** "multipart/form-data; boundary=..." */
+    char content_type[96];
+
+    /** The parts (struct multipart_part elements). */
+    chillbuff parts;
+
+    /** Total body size. */
+    size_t content_length;
+
+    /** Index of the part that's currently being sent (the parts count once the closing delimiter is being sent). */
+    size_t part;
+
+    /** Which section of the current part is being sent. */
+    int stage;
+
+    /** How much of the current section has been sent. */
+    size_t offset;
+
+#ifdef _WIN32
+    /** The currently sent file part. */
+    FILE* file;
+#else
+    /** The currently sent file part (<code>-1</code> if none is open). */
+    int fd;
+#endif
+};
+
+/** @private */
+static const char crlf[] = "\r\n";
+
+/** @private */
+static int name_char_needs_escaping(const char c)
+{
+    return c == '"' || c == '\r' || c == '\n';
+}
+
+/**
+ * @private
+ * Appends a quoted Content-Disposition parameter value, percent-encoding the few characters that would break out of the quoted string (like browsers do).
+ */
+static void push_quoted(chillbuff* builder, const char* value)
+{
+    chillbuff_push_back(builder, "\"", 1);
+
+    for (const char* c = value; *c != '\0'; ++c)
+    {
+        if (name_char_needs_escaping(*c))
+        {
+            char escaped[4];
+            snprintf(escaped, sizeof(escaped), "%%%02X", (unsigned char)*c);
+            chillbuff_push_back(builder, escaped, 3);
+            continue;
+        }
+
+        const char* run_end = c;
+        while (run_end[1] != '\0' && !name_char_needs_escaping(run_end[1]))
+        {
+            ++run_end;
+        }
+
+        chillbuff_push_back(builder, c, run_end - c + 1);
+        c = run_end;
+    }
+
+    chillbuff_push_back(builder, "\"", 1);
+}
+
+/** @private */
+static size_t closing_delimiter_length(const struct glitchedhttps_multipart* multipart)
+{
+    /* "--" boundary "--" CRLF */
+    return 2 + strlen(multipart->boundary) + 2 + 2;
+}
+
+struct glitchedhttps_multipart* glitchedhttps_multipart_init()
+{
+    struct glitchedhttps_multipart* multipart = calloc(1, sizeof(struct glitchedhttps_multipart));
+    if (multipart == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return NULL;
+    }
+
+    if (chillbuff_init(&multipart->parts, 8, sizeof(struct multipart_part), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
+    {
+        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper parts list... Perhaps go check out the chillbuff error logs!", __func__);
+        free(multipart);
+        return NULL;
+    }
+
+    const struct glitchedhttps_guid guid = glitchedhttps_new_guid(1, 0);
+
+    snprintf(multipart->boundary, sizeof(multipart->boundary), "----glitchedhttps%s", guid.string);
+    snprintf(multipart->content_type, sizeof(multipart->content_type), "multipart/form-data; boundary=%s", multipart->boundary);
+
+    multipart->content_length = closing_delimiter_length(multipart);
+
+#ifndef _WIN32
+    multipart->fd = -1;
+#endif
+    return multipart;
+}
+
+/**
+ * @private
+ * Serializes a part's delimiter line and header section and adds the part to the list.
+ */
+static int add_part(struct glitchedhttps_multipart* multipart, struct multipart_part* part, const char* name, const char* filename, const char* content_type)
+{
+    const char content_disposition[] = "Content-Disposition: form-data; name=";
+    const size_t content_disposition_length = 37;
+
+    const char content_type_header[] = "Content-Type: ";
+    const size_t content_type_header_length = 14;
+
+    chillbuff head;
+    if (chillbuff_init(&head, 128, sizeof(char), CHILLBUFF_GROW_DUPLICATIVE) != CHILLBUFF_SUCCESS)
+    {
+        glitchedhttps_log_error("Chillbuff init failed: can't proceed without a proper part header builder... Perhaps go check out the chillbuff error logs!", __func__);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    chillbuff_push_back(&head, "--", 2);
+    chillbuff_push_back(&head, multipart->boundary, strlen(multipart->boundary));
+    chillbuff_push_back(&head, crlf, 2);
+
+    chillbuff_push_back(&head, content_disposition, content_disposition_length);
+    push_quoted(&head, name);
+
+    if (filename != NULL)
+    {
+        chillbuff_push_back(&head, "; filename=", 11);
+        push_quoted(&head, filename);
+    }
+
+    chillbuff_push_back(&head, crlf, 2);
+
+    if (content_type != NULL)
+    {
+        chillbuff_push_back(&head, content_type_header, content_type_header_length);
+        chillbuff_push_back(&head, content_type, strlen(content_type));
+        chillbuff_push_back(&head, crlf, 2);
+    }
+
+    chillbuff_push_back(&head, crlf, 2);
+
+    part->head = malloc(head.length);
+    if (part->head == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        chillbuff_free(&head);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    memcpy(part->head, head.array, head.length);
+    part->head_length = head.length;
+    chillbuff_free(&head);
+
+    if (chillbuff_push_back(&multipart->parts, part, 1) != CHILLBUFF_SUCCESS)
+    {
+        glitchedhttps_log_error("Failed to add the part to the multipart body!", __func__);
+        free(part->head);
+        return GLITCHEDHTTPS_CHILLBUFF_ERROR;
+    }
+
+    /* Part head + content + the CRLF that belongs to the next delimiter. */
+    multipart->content_length += part->head_length + part->data_length + 2;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+int glitchedhttps_multipart_add_data(struct glitchedhttps_multipart* multipart, const char* name, const char* data, const size_t data_length, const char* content_type)
+{
+    if (multipart == NULL || name == NULL || data == NULL)
+    {
+        glitchedhttps_log_error("Multipart body, part name or part data NULL!", __func__);
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    struct multipart_part part;
+    memset(&part, 0x00, sizeof(part));
+
+    part.data = data;
+    part.data_length = data_length > 0 ? data_length : strlen(data);
+
+    return add_part(multipart, &part, name, NULL, content_type);
+}
+
+int glitchedhttps_multipart_add_file(struct glitchedhttps_multipart* multipart, const char* name, const char* path, const char* filename, const char* content_type)
+{
+    if (multipart == NULL || name == NULL || path == NULL)
+    {
+        glitchedhttps_log_error("Multipart body, part name or file path NULL!", __func__);
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+#ifdef _WIN32
+    struct _stat64 file_info;
+    if (_stat64(path, &file_info) != 0 || (file_info.st_mode & S_IFMT) != S_IFREG)
+#else
+    struct stat file_info;
+    if (stat(path, &file_info) != 0 || (file_info.st_mode & S_IFMT) != S_IFREG)
+#endif
+    {
+        glitchedhttps_log_error("The file to add to the multipart body doesn't exist (or isn't a regular file)!", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    if (filename == NULL)
+    {
+        filename = path;
+        for (const char* c = path; *c != '\0'; ++c)
+        {
+            if (*c == '/' || *c == '\\')
+            {
+                filename = c + 1;
+            }
+        }
+    }
+
+    struct multipart_part part;
+    memset(&part, 0x00, sizeof(part));
+
+    part.data_length = (size_t)file_info.st_size;
+    part.path = malloc(strlen(path) + 1);
+
+    if (part.path == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    strcpy(part.path, path);
+
+    const int r = add_part(multipart, &part, name, filename, content_type != NULL ? content_type : "application/octet-stream");
+    if (r != GLITCHEDHTTPS_SUCCESS)
+    {
+        free(part.path);
+    }
+
+    return r;
+}
+
+size_t glitchedhttps_multipart_content_length(const struct glitchedhttps_multipart* multipart)
+{
+    return multipart != NULL ? multipart->content_length : 0;
+}
+
+const char* glitchedhttps_multipart_content_type(const struct glitchedhttps_multipart* multipart)
+{
+    return multipart != NULL ? multipart->content_type : NULL;
+}
+
+/** @private Closes the file of the current file part (if one is open). */
+static void close_file(struct glitchedhttps_multipart* multipart)
+{
+#ifdef _WIN32
+    if (multipart->file != NULL)
+    {
+        fclose(multipart->file);
+        multipart->file = NULL;
+    }
+#else
+    if (multipart->fd >= 0)
+    {
+        close(multipart->fd);
+        multipart->fd = -1;
+    }
+#endif
+}
+
+/**
+ * @private
+ * Opens the file of a file part that's about to be sent. Empty files aren't opened at all.
+ */
+static int open_file(struct glitchedhttps_multipart* multipart, const struct multipart_part* part)
+{
+    if (part->data_length == 0)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+#ifdef _WIN32
+    multipart->file = fopen(part->path, "rb");
+    if (multipart->file == NULL)
+    {
+        glitchedhttps_log_error("Failed to open a multipart body file part!", __func__);
+        return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+    }
+
+    struct _stat64 file_info;
+    if (_fstat64(_fileno(multipart->file), &file_info) != 0 || (size_t)file_info.st_size != part->data_length)
+    {
+        glitchedhttps_log_error("A multipart body file part changed its size after it was added!", __func__);
+        close_file(multipart);
+        return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+    }
+#else
+    const int fd = open(part->path, O_RDONLY);
+    if (fd < 0)
+    {
+        glitchedhttps_log_error("Failed to open a multipart body file part!", __func__);
+        return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+    }
+
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0 || (size_t)file_info.st_size != part->data_length)
+    {
+        glitchedhttps_log_error("A multipart body file part changed its size after it was added!", __func__);
+        close(fd);
+        return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+    }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    /* The file is read front to back exactly once: let the kernel read ahead aggressively. */
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    multipart->fd = fd;
+#endif
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * Copies the next piece of a section into the send buffer.
+ * @param source The section's data, or <code>NULL</code> to read it from the currently open file part instead.
+ */
+static int copy_section(struct glitchedhttps_multipart* multipart, const char* source, const size_t section_length, char* buffer, const size_t capacity, size_t* written)
+{
+    size_t n = section_length - multipart->offset;
+    if (n > capacity - *written)
+    {
+        n = capacity - *written;
+    }
+
+    if (source != NULL)
+    {
+        memcpy(buffer + *written, source + multipart->offset, n);
+    }
+#ifdef _WIN32
+    else if (fread(buffer + *written, 1, n, multipart->file) != n)
+    {
+        glitchedhttps_log_error("Failed to read a multipart body file part!", __func__);
+        return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+    }
+#else
+    else
+    {
+        /* Read straight into the send buffer: a file that shrank in the meantime is a short read (and thus an error) instead of a crash. */
+        for (size_t read_total = 0; read_total < n;)
+        {
+            const ssize_t r = pread(multipart->fd, buffer + *written + read_total, n - read_total, (off_t)(multipart->offset + read_total));
+
+            if (r < 0 && errno == EINTR)
+                continue;
+
+            if (r <= 0)
+            {
+                glitchedhttps_log_error(r < 0 ? "Failed to read a multipart body file part!" : "A multipart body file part shrank while it was being sent!", __func__);
+                return GLITCHEDHTTPS_REQUEST_BODY_READ_FAILED;
+            }
+
+            read_total += (size_t)r;
+        }
+    }
+#endif
+
+    multipart->offset += n;
+    *written += n;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+/**
+ * @private
+ * The glitchedhttps_request::read_body callback: fills the send buffer with the next piece of the multipart body (walking through the parts' heads, contents and delimiters).
+ */
+static ptrdiff_t multipart_read(char* buffer, const size_t capacity, void* userdata)
+{
+    struct glitchedhttps_multipart* multipart = (struct glitchedhttps_multipart*)userdata;
+    const struct multipart_part* parts = (const struct multipart_part*)multipart->parts.array;
+
+    size_t written = 0;
+
+    while (written < capacity && multipart->part < multipart->parts.length)
+    {
+        const struct multipart_part* part = parts + multipart->part;
+        const char* source = NULL;
+        size_t section_length = 0;
+
+        switch (multipart->stage)
+        {
+            case GLITCHEDHTTPS_MULTIPART_STAGE_HEAD:
+                source = part->head;
+                section_length = part->head_length;
+                break;
+            case GLITCHEDHTTPS_MULTIPART_STAGE_DATA:
+                source = part->data;
+                section_length = part->data_length;
+                break;
+            default:
+                source = crlf;
+                section_length = 2;
+                break;
+        }
+
+        if (copy_section(multipart, source, section_length, buffer, capacity, &written) != GLITCHEDHTTPS_SUCCESS)
+        {
+            return -1;
+        }
+
+        if (multipart->offset < section_length)
+        {
+            break;
+        }
+
+        multipart->offset = 0;
+
+        switch (multipart->stage)
+        {
+            case GLITCHEDHTTPS_MULTIPART_STAGE_HEAD:
+                if (part->path != NULL && open_file(multipart, part) != GLITCHEDHTTPS_SUCCESS)
+                {
+                    return -1;
+                }
+                multipart->stage = GLITCHEDHTTPS_MULTIPART_STAGE_DATA;
+                break;
+            case GLITCHEDHTTPS_MULTIPART_STAGE_DATA:
+                close_file(multipart);
+                multipart->stage = GLITCHEDHTTPS_MULTIPART_STAGE_CRLF;
+                break;
+            default:
+                multipart->stage = GLITCHEDHTTPS_MULTIPART_STAGE_HEAD;
+                ++multipart->part;
+                break;
+        }
+    }
+
+    if (written < capacity && multipart->part == multipart->parts.length)
+    {
+        /* The closing delimiter: "--" boundary "--" CRLF */
+        char closing_delimiter[sizeof(multipart->boundary) + 6];
+        const size_t closing_delimiter_length = snprintf(closing_delimiter, sizeof(closing_delimiter), "--%s--\r\n", multipart->boundary);
+
+        if (multipart->offset < closing_delimiter_length)
+        {
+            copy_section(multipart, closing_delimiter, closing_delimiter_length, buffer, capacity, &written);
+        }
+    }
+
+    return (ptrdiff_t)written;
+}
+
+/** @private Goes back to the start of the body (closing the file that was being sent, if any). */
+static void rewind_multipart(struct glitchedhttps_multipart* multipart)
+{
+    if (multipart->part < multipart->parts.length)
+    {
+        close_file(multipart);
+    }
+
+    multipart->part = 0;
+    multipart->stage = GLITCHEDHTTPS_MULTIPART_STAGE_HEAD;
+    multipart->offset = 0;
+}
+
+int glitchedhttps_multipart_attach(struct glitchedhttps_multipart* multipart, struct glitchedhttps_request* request)
+{
+    if (multipart == NULL || request == NULL)
+    {
+        glitchedhttps_log_error("Multipart body or request NULL!", __func__);
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    rewind_multipart(multipart);
+
+    request->read_body = &multipart_read;
+    request->userdata = multipart;
+    request->content_length = multipart->content_length;
+    request->content_type = multipart->content_type;
+    request->content_type_length = 0;
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+void glitchedhttps_multipart_free(struct glitchedhttps_multipart* multipart)
+{
+    if (multipart == NULL)
+    {
+        return;
+    }
+
+    rewind_multipart(multipart);
+
+    struct multipart_part* parts = (struct multipart_part*)multipart->parts.array;
+
+    for (size_t i = 0; i < multipart->parts.length; ++i)
+    {
+        free(parts[i].head);
+        free(parts[i].path);
+    }
+
+    chillbuff_free(&multipart->parts);
+    free(multipart);
+}
+
+#undef GLITCHEDHTTPS_MULTIPART_STAGE_HEAD
+#undef GLITCHEDHTTPS_MULTIPART_STAGE_DATA
+#undef GLITCHEDHTTPS_MULTIPART_STAGE_CRLF
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
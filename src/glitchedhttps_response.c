@@ -19,7 +19,423 @@ extern "C" {
 #endif
 
 #include "glitchedhttps_response.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include "glitchedhttps_strutil.h"
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+/** @private */
+struct glitchedhttps_header_index
+{
+    /** Amount of hash slots (always a power of 2). */
+    size_t slots_count;
+
+    /** Hash slots: index + 1 of the first header with a given name (0 means empty). */
+    size_t* slots;
+
+    /** For each header: index + 1 of the next header with the same name (0 means there's none). */
+    size_t* next;
+
+    /** How many headers the {@link #next} array has room for. */
+    size_t next_capacity;
+};
+
+#if defined(_MSC_VER)
+#define GLITCHEDHTTPS_THREAD_LOCAL __declspec(thread)
+#else
+#define GLITCHEDHTTPS_THREAD_LOCAL _Thread_local
+#endif
+
+/** @private Recycled responses of the current thread (see glitchedhttps_response_recycle()). */
+static GLITCHEDHTTPS_THREAD_LOCAL struct glitchedhttps_response* response_pool[GLITCHEDHTTPS_RESPONSE_POOL_SIZE];
+
+/** @private */
+static GLITCHEDHTTPS_THREAD_LOCAL size_t response_pool_count = 0;
+
+/** @private */
+static size_t hash_header_name(const char* name, const size_t name_length)
+{
+    /* FNV-1a over the lowercased name. */
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < name_length; ++i)
+    {
+        hash ^= (uint8_t)glitchedhttps_tolower_ascii(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** @private */
+static int header_name_equals(const struct glitchedhttps_header* header, const char* name, const size_t name_length)
+{
+    return glitchedhttps_header_type_length(header) == name_length && glitchedhttps_strnequalic(header->type, name, name_length);
+}
+
+/** @private */
+static char* copy_string(const char* string, const size_t length)
+{
+    char* out = malloc(length + 1);
+    if (out == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(out, string, length);
+    out[length] = '\0';
+    return out;
+}
+
+/**
+ * @private
+ * Moves a live buffer of a response over to its retained buffers (freeing whatever was retained in its place before).
+ * @return What's retained now.
+ */
+static void* retain(void* retained, void* buffer)
+{
+    if (buffer == NULL)
+    {
+        return retained;
+    }
+
+    free(retained);
+    return buffer;
+}
+
+/**
+ * @private
+ * Turns lazily recorded header lines into glitchedhttps_header instances (in front of the chunked trailer fields that may already be in the header array),
+ * fills in the server, date and content type fields and indexes the result.
+ */
+static int materialize_headers(struct glitchedhttps_response* response)
+{
+    if (response->header_lines == NULL)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    const size_t lines_count = response->header_lines_count;
+    struct glitchedhttps_header* headers = calloc(lines_count + response->headers_count, sizeof(struct glitchedhttps_header));
+    if (headers == NULL)
+    {
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    for (size_t i = 0; i < lines_count; ++i)
+    {
+        /* The response parser only records lines that contain a colon (preceded by a non-empty field name). */
+        const char* line = response->raw + response->header_lines[i].offset;
+        const char* colon = memchr(line, ':', response->header_lines[i].length);
+        const char* line_end = line + response->header_lines[i].length;
+        const size_t type_length = colon - line;
+
+        const char* value = colon + 1;
+        while (value < line_end && (*value == ' ' || *value == '\t'))
+            ++value;
+
+        size_t value_length = line_end - value;
+        while (value_length > 0 && (value[value_length - 1] == ' ' || value[value_length - 1] == '\t'))
+            --value_length;
+
+        headers[i].type = copy_string(line, type_length);
+        headers[i].value = copy_string(value, value_length);
+
+        if (headers[i].type == NULL || headers[i].value == NULL)
+        {
+            goto out_of_mem;
+        }
+
+        headers[i].type_length = type_length;
+        headers[i].value_length = value_length;
+
+        char** field = NULL;
+
+        switch (glitchedhttps_header_lookup(line, type_length))
+        {
+            case GLITCHEDHTTPS_HEADER_SERVER:
+                field = &response->server;
+                break;
+            case GLITCHEDHTTPS_HEADER_DATE:
+                field = &response->date;
+                break;
+            case GLITCHEDHTTPS_HEADER_CONTENT_TYPE:
+                field = &response->content_type;
+                break;
+            default:
+                break;
+        }
+
+        /* Just like when parsing eagerly, the first occurrence of a header wins. */
+        if (field != NULL && *field == NULL && (*field = copy_string(value, value_length)) == NULL)
+        {
+            goto out_of_mem;
+        }
+    }
+
+    if (response->headers_count > 0)
+    {
+        memcpy(headers + lines_count, response->headers, response->headers_count * sizeof(struct glitchedhttps_header));
+    }
+
+    free(response->headers);
+    response->headers = headers;
+    response->headers_count += lines_count;
+    response->buffers.headers_capacity = response->headers_count;
+
+    /* Keep the line array around in case the response is reused. */
+    response->buffers.header_lines = retain(response->buffers.header_lines, response->header_lines);
+    response->header_lines = NULL;
+    response->header_lines_count = 0;
+
+    glitchedhttps_response_index_headers(response);
+    return GLITCHEDHTTPS_SUCCESS;
+
+out_of_mem:
+    glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+    for (size_t i = 0; i < lines_count; ++i)
+    {
+        free(headers[i].type);
+        free(headers[i].value);
+    }
+    free(headers);
+    return GLITCHEDHTTPS_OUT_OF_MEM;
+}
+
+int glitchedhttps_response_index_headers(struct glitchedhttps_response* response)
+{
+    if (response == NULL)
+    {
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    struct glitchedhttps_header_index* index = response->header_index;
+    response->header_index = NULL;
+
+    if (response->headers_count == 0)
+    {
+        free(index);
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    /* Keep the load factor at or below 50%. */
+    size_t slots_count = 8;
+    while (slots_count < response->headers_count * 2)
+    {
+        slots_count <<= 1;
+    }
+
+    if (index != NULL && index->slots_count == slots_count && index->next_capacity >= response->headers_count)
+    {
+        /* A reused response with a similar amount of headers as last time: the old index has the right size. */
+        memset(index->slots, 0x00, (slots_count + index->next_capacity) * sizeof(size_t));
+    }
+    else
+    {
+        free(index);
+
+        index = calloc(1, sizeof(struct glitchedhttps_header_index) + (slots_count + response->headers_count) * sizeof(size_t));
+        if (index == NULL)
+        {
+            return GLITCHEDHTTPS_OUT_OF_MEM;
+        }
+
+        index->slots_count = slots_count;
+        index->slots = (size_t*)(index + 1);
+        index->next = index->slots + slots_count;
+        index->next_capacity = response->headers_count;
+    }
+
+    for (size_t i = 0; i < response->headers_count; ++i)
+    {
+        const char* name = response->headers[i].type;
+        const size_t name_length = glitchedhttps_header_type_length(&response->headers[i]);
+
+        size_t slot = hash_header_name(name, name_length) & (slots_count - 1);
+
+        while (index->slots[slot] != 0 && !header_name_equals(&response->headers[index->slots[slot] - 1], name, name_length))
+        {
+            slot = (slot + 1) & (slots_count - 1);
+        }
+
+        if (index->slots[slot] == 0)
+        {
+            index->slots[slot] = i + 1;
+            continue;
+        }
+
+        /* Multi-valued header: append it to the end of the chain of headers with the same name. */
+        size_t last = index->slots[slot] - 1;
+        while (index->next[last] != 0)
+        {
+            last = index->next[last] - 1;
+        }
+        index->next[last] = i + 1;
+    }
+
+    response->header_index = index;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+const struct glitchedhttps_header* glitchedhttps_response_get_headers(struct glitchedhttps_response* response, size_t* headers_count)
+{
+    if (headers_count != NULL)
+    {
+        *headers_count = 0;
+    }
+
+    if (response == NULL || materialize_headers(response) != GLITCHEDHTTPS_SUCCESS)
+    {
+        return NULL;
+    }
+
+    if (headers_count != NULL)
+    {
+        *headers_count = response->headers_count;
+    }
+
+    return response->headers;
+}
+
+const struct glitchedhttps_header* glitchedhttps_response_get_header(struct glitchedhttps_response* response, const char* name, size_t name_length)
+{
+    if (response == NULL || name == NULL || glitchedhttps_response_get_headers(response, NULL) == NULL)
+    {
+        return NULL;
+    }
+
+    if (name_length == 0)
+    {
+        name_length = strlen(name);
+    }
+
+    const struct glitchedhttps_header_index* index = response->header_index;
+
+    if (index == NULL)
+    {
+        for (size_t i = 0; i < response->headers_count; ++i)
+        {
+            if (header_name_equals(&response->headers[i], name, name_length))
+            {
+                return &response->headers[i];
+            }
+        }
+        return NULL;
+    }
+
+    size_t slot = hash_header_name(name, name_length) & (index->slots_count - 1);
+
+    while (index->slots[slot] != 0)
+    {
+        const struct glitchedhttps_header* header = &response->headers[index->slots[slot] - 1];
+        if (header_name_equals(header, name, name_length))
+        {
+            return header;
+        }
+        slot = (slot + 1) & (index->slots_count - 1);
+    }
+
+    return NULL;
+}
+
+const struct glitchedhttps_header* glitchedhttps_response_next_header(const struct glitchedhttps_response* response, const struct glitchedhttps_header* header)
+{
+    if (response == NULL || header == NULL || header < response->headers || header >= response->headers + response->headers_count)
+    {
+        return NULL;
+    }
+
+    const size_t i = header - response->headers;
+
+    if (response->header_index != NULL)
+    {
+        const size_t next = response->header_index->next[i];
+        return next != 0 ? &response->headers[next - 1] : NULL;
+    }
+
+    const size_t name_length = glitchedhttps_header_type_length(header);
+    for (size_t j = i + 1; j < response->headers_count; ++j)
+    {
+        if (header_name_equals(&response->headers[j], header->type, name_length))
+        {
+            return &response->headers[j];
+        }
+    }
+
+    return NULL;
+}
+
+
+void glitchedhttps_response_reset(struct glitchedhttps_response* response)
+{
+    if (response == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < response->headers_count; ++i)
+    {
+        free(response->headers[i].type);
+        free(response->headers[i].value);
+    }
+
+    free(response->server);
+    free(response->date);
+    free(response->content_type);
+    free(response->content_encoding);
+
+    struct glitchedhttps_response_buffers* buffers = &response->buffers;
+
+    buffers->raw = retain(buffers->raw, response->raw);
+    buffers->content = retain(buffers->content, response->content);
+    buffers->headers = retain(buffers->headers, response->headers);
+    buffers->header_lines = retain(buffers->header_lines, response->header_lines);
+
+    response->status_code = -1;
+    response->raw = NULL;
+    response->server = NULL;
+    response->date = NULL;
+    response->content_type = NULL;
+    response->content_encoding = NULL;
+    response->content = NULL;
+    response->content_length = 0;
+    response->headers = NULL;
+    response->headers_count = 0;
+    response->header_lines = NULL;
+    response->header_lines_count = 0;
+
+    /* The header index is kept too: it's only ever consulted for a non-empty header array, and is rebuilt (in place, if possible) whenever the headers change. */
+}
+
+void glitchedhttps_response_recycle(struct glitchedhttps_response* response)
+{
+    if (response == NULL)
+    {
+        return;
+    }
+
+    if (response_pool_count == GLITCHEDHTTPS_RESPONSE_POOL_SIZE)
+    {
+        glitchedhttps_response_free(response);
+        return;
+    }
+
+    glitchedhttps_response_reset(response);
+    response_pool[response_pool_count++] = response;
+}
+
+struct glitchedhttps_response* glitchedhttps_response_pool_take(void)
+{
+    return response_pool_count > 0 ? response_pool[--response_pool_count] : NULL;
+}
+
+void glitchedhttps_response_pool_clear(void)
+{
+    while (response_pool_count > 0)
+    {
+        glitchedhttps_response_free(response_pool[--response_pool_count]);
+    }
+}
 
 void glitchedhttps_response_free(struct glitchedhttps_response* response)
 {
@@ -58,12 +474,25 @@ void glitchedhttps_response_free(struct glitchedhttps_response* response)
             free(h->type);
             free(h->value);
         }
-        free(response->headers);
     }
 
+    free(response->headers);
+
+    free(response->header_index);
+
+    free(response->header_lines);
+
+    free(response->buffers.raw);
+    free(response->buffers.content);
+    free(response->buffers.headers);
+    free(response->buffers.header_lines);
+    free(response->buffers.receive_buffer);
+
     free(response);
 }
 
+#undef GLITCHEDHTTPS_THREAD_LOCAL
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
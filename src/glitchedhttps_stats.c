@@ -0,0 +1,68 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_stats.h"
+#include <stddef.h>
+
+/* Requests may run on several threads at once: use atomic counters wherever C11 atomics are available. */
+#if !defined(__STDC_NO_ATOMICS__) && !defined(_MSC_VER)
+#include <stdatomic.h>
+typedef _Atomic uint64_t glitchedhttps_counter;
+#define GLITCHEDHTTPS_COUNTER_ADD(counter, n) atomic_fetch_add_explicit(&(counter), (n), memory_order_relaxed)
+#define GLITCHEDHTTPS_COUNTER_LOAD(counter) atomic_load_explicit(&(counter), memory_order_relaxed)
+#define GLITCHEDHTTPS_COUNTER_STORE(counter, n) atomic_store_explicit(&(counter), (n), memory_order_relaxed)
+#else
+typedef volatile uint64_t glitchedhttps_counter;
+#define GLITCHEDHTTPS_COUNTER_ADD(counter, n) ((counter) += (n))
+#define GLITCHEDHTTPS_COUNTER_LOAD(counter) (counter)
+#define GLITCHEDHTTPS_COUNTER_STORE(counter, n) ((counter) = (n))
+#endif
+
+static glitchedhttps_counter receive_buffer_growths = 0;
+static glitchedhttps_counter receive_buffer_bytes_copied = 0;
+
+void glitchedhttps_get_stats(struct glitchedhttps_stats* out)
+{
+    if (out == NULL)
+        return;
+
+    out->receive_buffer_growths = GLITCHEDHTTPS_COUNTER_LOAD(receive_buffer_growths);
+    out->receive_buffer_bytes_copied = GLITCHEDHTTPS_COUNTER_LOAD(receive_buffer_bytes_copied);
+}
+
+void glitchedhttps_reset_stats()
+{
+    GLITCHEDHTTPS_COUNTER_STORE(receive_buffer_growths, 0);
+    GLITCHEDHTTPS_COUNTER_STORE(receive_buffer_bytes_copied, 0);
+}
+
+void glitchedhttps_stats_count_receive_buffer_growth(const uint64_t bytes_copied)
+{
+    GLITCHEDHTTPS_COUNTER_ADD(receive_buffer_growths, 1);
+    GLITCHEDHTTPS_COUNTER_ADD(receive_buffer_bytes_copied, bytes_copied);
+}
+
+#undef GLITCHEDHTTPS_COUNTER_ADD
+#undef GLITCHEDHTTPS_COUNTER_LOAD
+#undef GLITCHEDHTTPS_COUNTER_STORE
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
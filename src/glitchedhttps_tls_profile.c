@@ -0,0 +1,228 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <mbedtls/ssl.h>
+#include <mbedtls/ssl_ciphersuites.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/version.h>
+
+/* The AES-NI detection is only public API in mbedtls 2 (in 3 the header went private). */
+#if defined(MBEDTLS_AESNI_C) && defined(MBEDTLS_HAVE_X86_64) && MBEDTLS_VERSION_NUMBER < 0x03000000
+#define GLITCHEDHTTPS_AESNI 1
+#include <mbedtls/aesni.h>
+#endif
+
+#include "glitchedhttps_tls_profile.h"
+#include <stddef.h>
+
+#ifndef GLITCHEDHTTPS_TLS_PROFILE_MAX_CIPHERSUITES
+/**
+ * @private
+ * Capacity of the (static) cipher suite list that a profile gets written into. A full mbedtls 2 build has less than 200 cipher suites.
+ */
+#define GLITCHEDHTTPS_TLS_PROFILE_MAX_CIPHERSUITES 512
+#endif
+
+#ifndef GLITCHEDHTTPS_TLS_PROFILE_MAX_CURVES
+/** @private Capacity of the (static) curve list that a profile gets written into. */
+#define GLITCHEDHTTPS_TLS_PROFILE_MAX_CURVES 32
+#endif
+
+/** @private Zero-terminated, most preferred first. */
+static const int throughput_ciphersuites[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+    0,
+};
+
+/** @private Zero-terminated, most preferred first. */
+static const int low_power_ciphersuites[] = {
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+    0,
+};
+
+#if defined(MBEDTLS_ECP_C)
+/** @private Terminated by <code>MBEDTLS_ECP_DP_NONE</code>, most preferred first. */
+static const mbedtls_ecp_group_id preferred_curves[] = {
+    MBEDTLS_ECP_DP_CURVE25519,
+    MBEDTLS_ECP_DP_SECP256R1,
+    MBEDTLS_ECP_DP_SECP384R1,
+    MBEDTLS_ECP_DP_NONE,
+};
+
+/** @private */
+static mbedtls_ecp_group_id curves[GLITCHEDHTTPS_TLS_PROFILE_MAX_CURVES + 1];
+#endif
+
+/** @private */
+static int ciphersuites[GLITCHEDHTTPS_TLS_PROFILE_MAX_CIPHERSUITES + 1];
+
+int glitchedhttps_tls_has_aes_acceleration()
+{
+#ifdef GLITCHEDHTTPS_AESNI
+    return mbedtls_aesni_has_support(MBEDTLS_AESNI_AES) != 0;
+#else
+    return 0;
+#endif
+}
+
+enum glitchedhttps_tls_profile glitchedhttps_tls_profile_resolve(const enum glitchedhttps_tls_profile profile)
+{
+    if (profile != GLITCHEDHTTPS_TLS_PROFILE_AUTO)
+    {
+        return profile;
+    }
+
+    return glitchedhttps_tls_has_aes_acceleration() ? GLITCHEDHTTPS_TLS_PROFILE_THROUGHPUT : GLITCHEDHTTPS_TLS_PROFILE_LOW_POWER;
+}
+
+const char* glitchedhttps_tls_profile_name(const enum glitchedhttps_tls_profile profile)
+{
+    switch (profile)
+    {
+        case GLITCHEDHTTPS_TLS_PROFILE_COMPAT:
+            return "compat";
+        case GLITCHEDHTTPS_TLS_PROFILE_THROUGHPUT:
+            return "throughput";
+        case GLITCHEDHTTPS_TLS_PROFILE_LOW_POWER:
+            return "low-power";
+        case GLITCHEDHTTPS_TLS_PROFILE_AUTO:
+            return "auto";
+        default:
+            return "unknown";
+    }
+}
+
+/** @private */
+static int contains_ciphersuite(const int* list, const size_t count, const int id)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (list[i] == id)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @private
+ * Writes the preferred cipher suites that this mbedtls build supports into the static list, followed by all of the remaining mbedtls defaults (in their default order).
+ */
+static void build_ciphersuites(const int* preferred)
+{
+    size_t count = 0;
+
+    for (const int* id = preferred; *id != 0 && count < GLITCHEDHTTPS_TLS_PROFILE_MAX_CIPHERSUITES; ++id)
+    {
+        if (mbedtls_ssl_ciphersuite_from_id(*id) != NULL)
+        {
+            ciphersuites[count++] = *id;
+        }
+    }
+
+    for (const int* id = mbedtls_ssl_list_ciphersuites(); *id != 0 && count < GLITCHEDHTTPS_TLS_PROFILE_MAX_CIPHERSUITES; ++id)
+    {
+        if (!contains_ciphersuite(ciphersuites, count, *id))
+        {
+            ciphersuites[count++] = *id;
+        }
+    }
+
+    ciphersuites[count] = 0;
+}
+
+#if defined(MBEDTLS_ECP_C)
+/**
+ * @private
+ * Same as build_ciphersuites() but for the curves: a curve that mbedtls wasn't built with would make the handshake fail, so only the known ones make it into the list.
+ */
+static void build_curves()
+{
+    size_t count = 0;
+
+    for (const mbedtls_ecp_group_id* id = preferred_curves; *id != MBEDTLS_ECP_DP_NONE; ++id)
+    {
+        if (mbedtls_ecp_curve_info_from_grp_id(*id) != NULL)
+        {
+            curves[count++] = *id;
+        }
+    }
+
+    for (const mbedtls_ecp_group_id* id = mbedtls_ecp_grp_id_list(); *id != MBEDTLS_ECP_DP_NONE && count < GLITCHEDHTTPS_TLS_PROFILE_MAX_CURVES; ++id)
+    {
+        size_t i = 0;
+        while (i < count && curves[i] != *id)
+        {
+            ++i;
+        }
+
+        if (i == count)
+        {
+            curves[count++] = *id;
+        }
+    }
+
+    curves[count] = MBEDTLS_ECP_DP_NONE;
+}
+#endif
+
+enum glitchedhttps_tls_profile glitchedhttps_tls_profile_apply(struct mbedtls_ssl_config* ssl_config, const enum glitchedhttps_tls_profile profile)
+{
+    const enum glitchedhttps_tls_profile resolved = glitchedhttps_tls_profile_resolve(profile);
+
+    switch (resolved)
+    {
+        case GLITCHEDHTTPS_TLS_PROFILE_THROUGHPUT:
+            build_ciphersuites(throughput_ciphersuites);
+            break;
+        case GLITCHEDHTTPS_TLS_PROFILE_LOW_POWER:
+            build_ciphersuites(low_power_ciphersuites);
+            break;
+        default:
+            /* These are exactly the lists that mbedtls_ssl_config_defaults() sets up. */
+            mbedtls_ssl_conf_ciphersuites(ssl_config, mbedtls_ssl_list_ciphersuites());
+#if defined(MBEDTLS_ECP_C)
+            mbedtls_ssl_conf_curves(ssl_config, mbedtls_ecp_grp_id_list());
+#endif
+            return GLITCHEDHTTPS_TLS_PROFILE_COMPAT;
+    }
+
+    mbedtls_ssl_conf_ciphersuites(ssl_config, ciphersuites);
+
+#if defined(MBEDTLS_ECP_C)
+    build_curves();
+    mbedtls_ssl_conf_curves(ssl_config, curves);
+#endif
+
+    return resolved;
+}
+
+#undef GLITCHEDHTTPS_AESNI
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
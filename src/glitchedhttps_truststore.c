@@ -0,0 +1,630 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/asn1.h>
+#include <mbedtls/sha1.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/platform.h>
+#include <mbedtls/version.h>
+
+#include "glitchedhttps_truststore.h"
+#include "glitchedhttps_cacerts.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include "chillbuff.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/** @private An indexed root certificate: where it (and its subject name) lie inside the embedded DER blob. */
+struct trusted_root
+{
+    const unsigned char* der;
+    size_t der_length;
+    const unsigned char* subject;
+    size_t subject_length;
+};
+
+/** @private */
+static struct trusted_root* roots = NULL;
+
+/** @private */
+static size_t roots_count = 0;
+
+/** @private Open addressing hash table over the subject names: each slot holds a root's index + 1 (zero means empty). */
+static size_t* slots = NULL;
+
+/** @private */
+static size_t slots_count = 0;
+
+/** @private Per root: index + 1 of the next root with the very same subject (e.g. re-issued or cross-signed roots), zero at the end of the chain. */
+static size_t* next = NULL;
+
+/** @private The hashed CA certificates directory that roots are looked up in (instead of the embedded ones), if any. */
+static const char* ca_certs_dir = NULL;
+
+/** @private */
+static size_t hash_name(const unsigned char* name, const size_t name_length)
+{
+    /* FNV-1a over the raw DER of the name. */
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < name_length; ++i)
+    {
+        hash ^= name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/** @private */
+static int root_has_subject(const struct trusted_root* root, const unsigned char* name, const size_t name_length)
+{
+    return root->subject_length == name_length && memcmp(root->subject, name, name_length) == 0;
+}
+
+/**
+ * @private
+ * Finds a DER certificate's subject name (including its SEQUENCE tag and length, just like <code>mbedtls_x509_crt::subject_raw</code>)
+ * by skipping over the fields of the TBSCertificate that come before it.
+ */
+static int find_subject(const unsigned char* der, const size_t der_length, const unsigned char** subject, size_t* subject_length)
+{
+    unsigned char* p = (unsigned char*)der;
+    const unsigned char* end = der + der_length;
+    size_t length;
+
+    const int sequence = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE;
+
+    /* Certificate ::= SEQUENCE { tbsCertificate, ... }  and  TBSCertificate ::= SEQUENCE { ... } */
+    for (int i = 0; i < 2; ++i)
+    {
+        if (mbedtls_asn1_get_tag(&p, end, &length, sequence) != 0)
+        {
+            return -1;
+        }
+        end = p + length;
+    }
+
+    /* The version is optional: [0] EXPLICIT Version DEFAULT v1 */
+    if (mbedtls_asn1_get_tag(&p, end, &length, MBEDTLS_ASN1_CONTEXT_SPECIFIC | MBEDTLS_ASN1_CONSTRUCTED | 0) == 0)
+    {
+        p += length;
+    }
+
+    /* serialNumber, signature, issuer and validity. */
+    const int skipped[] = { MBEDTLS_ASN1_INTEGER, sequence, sequence, sequence };
+
+    for (size_t i = 0; i < sizeof(skipped) / sizeof(skipped[0]); ++i)
+    {
+        if (mbedtls_asn1_get_tag(&p, end, &length, skipped[i]) != 0)
+        {
+            return -1;
+        }
+        p += length;
+    }
+
+    const unsigned char* subject_begin = p;
+
+    if (mbedtls_asn1_get_tag(&p, end, &length, sequence) != 0)
+    {
+        return -1;
+    }
+
+    *subject = subject_begin;
+    *subject_length = (p + length) - subject_begin;
+    return 0;
+}
+
+/** @private */
+static int push_der_header(chillbuff* out, const unsigned char tag, const size_t length)
+{
+    unsigned char header[2 + sizeof(size_t)];
+    size_t header_length = 0;
+
+    header[header_length++] = tag;
+
+    if (length < 0x80)
+    {
+        header[header_length++] = (unsigned char)length;
+    }
+    else
+    {
+        size_t length_bytes = 0;
+        for (size_t l = length; l > 0; l >>= 8)
+        {
+            ++length_bytes;
+        }
+
+        header[header_length++] = (unsigned char)(0x80 | length_bytes);
+        for (size_t i = length_bytes; i > 0; --i)
+        {
+            header[header_length++] = (unsigned char)(length >> ((i - 1) * 8));
+        }
+    }
+
+    return chillbuff_push_back(out, header, header_length);
+}
+
+/** @private */
+static int push_utf8(chillbuff* out, const uint32_t code_point)
+{
+    unsigned char utf8[4];
+    size_t utf8_length;
+
+    if (code_point < 0x80)
+    {
+        utf8[0] = (unsigned char)code_point;
+        utf8_length = 1;
+    }
+    else if (code_point < 0x800)
+    {
+        utf8[0] = (unsigned char)(0xC0 | (code_point >> 6));
+        utf8[1] = (unsigned char)(0x80 | (code_point & 0x3F));
+        utf8_length = 2;
+    }
+    else if (code_point < 0x10000)
+    {
+        utf8[0] = (unsigned char)(0xE0 | (code_point >> 12));
+        utf8[1] = (unsigned char)(0x80 | ((code_point >> 6) & 0x3F));
+        utf8[2] = (unsigned char)(0x80 | (code_point & 0x3F));
+        utf8_length = 3;
+    }
+    else
+    {
+        utf8[0] = (unsigned char)(0xF0 | ((code_point >> 18) & 0x07));
+        utf8[1] = (unsigned char)(0x80 | ((code_point >> 12) & 0x3F));
+        utf8[2] = (unsigned char)(0x80 | ((code_point >> 6) & 0x3F));
+        utf8[3] = (unsigned char)(0x80 | (code_point & 0x3F));
+        utf8_length = 4;
+    }
+
+    return chillbuff_push_back(out, utf8, utf8_length);
+}
+
+/** @private */
+static int is_canonical_space(const unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/**
+ * @private
+ * Canonicalizes a directory string value the way OpenSSL does before hashing a name: UTF-8 (with the single byte string types taken as Latin-1),
+ * no leading or trailing whitespace, inner whitespace collapsed into one single space and ASCII lowercased.
+ * @return <code>0</code> if the value was written into \p out; <code>1</code> if its string type isn't canonicalized (and the value needs to be taken as it is); <code>-1</code> on failure.
+ */
+static int canonicalize_value(const unsigned char tag, const unsigned char* value, const size_t value_length, chillbuff* out)
+{
+    chillbuff_clear(out);
+
+    switch (tag)
+    {
+        case MBEDTLS_ASN1_UTF8_STRING:
+            if (chillbuff_push_back(out, value, value_length) != CHILLBUFF_SUCCESS)
+                return -1;
+            break;
+        case MBEDTLS_ASN1_PRINTABLE_STRING:
+        case MBEDTLS_ASN1_T61_STRING:
+        case MBEDTLS_ASN1_IA5_STRING:
+        case 0x1A: /* VisibleString */
+            for (size_t i = 0; i < value_length; ++i)
+            {
+                if (push_utf8(out, value[i]) != CHILLBUFF_SUCCESS)
+                    return -1;
+            }
+            break;
+        case MBEDTLS_ASN1_BMP_STRING:
+            if (value_length % 2 != 0)
+                return -1;
+            for (size_t i = 0; i < value_length; i += 2)
+            {
+                if (push_utf8(out, (uint32_t)value[i] << 8 | value[i + 1]) != CHILLBUFF_SUCCESS)
+                    return -1;
+            }
+            break;
+        case MBEDTLS_ASN1_UNIVERSAL_STRING:
+            if (value_length % 4 != 0)
+                return -1;
+            for (size_t i = 0; i < value_length; i += 4)
+            {
+                if (push_utf8(out, (uint32_t)value[i] << 24 | (uint32_t)value[i + 1] << 16 | (uint32_t)value[i + 2] << 8 | value[i + 3]) != CHILLBUFF_SUCCESS)
+                    return -1;
+            }
+            break;
+        default:
+            return 1;
+    }
+
+    unsigned char* text = out->array;
+    size_t begin = 0;
+    size_t end = out->length;
+
+    while (begin < end && is_canonical_space(text[begin]))
+        ++begin;
+
+    while (end > begin && is_canonical_space(text[end - 1]))
+        --end;
+
+    /* In place: the canonical value is never longer than the UTF-8 one. */
+    size_t length = 0;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (is_canonical_space(text[i]))
+        {
+            text[length++] = ' ';
+            while (is_canonical_space(text[i + 1]))
+                ++i;
+        }
+        else
+        {
+            text[length++] = text[i] >= 'A' && text[i] <= 'Z' ? (unsigned char)(text[i] - 'A' + 'a') : text[i];
+        }
+    }
+
+    out->length = length;
+    return 0;
+}
+
+/**
+ * @private
+ * Computes the OpenSSL hash of a DER-encoded X.509 name (the one that's used for the file names in hashed certificate directories, see <code>X509_NAME_hash()</code>):
+ * the first four bytes (little endian) of the SHA-1 of the name's canonical encoding, which is the concatenation of the name's relative distinguished name SETs with all of their string values canonicalized.
+ */
+static int openssl_name_hash(const unsigned char* name, const size_t name_length, uint32_t* hash)
+{
+    unsigned char* p = (unsigned char*)name;
+    const unsigned char* end = name + name_length;
+    size_t length;
+
+    if (mbedtls_asn1_get_tag(&p, end, &length, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0)
+    {
+        return -1;
+    }
+
+    end = p + length;
+
+    chillbuff canonical, set, attribute, value;
+    chillbuff_init(&canonical, 256, sizeof(unsigned char), CHILLBUFF_GROW_DUPLICATIVE);
+    chillbuff_init(&set, 128, sizeof(unsigned char), CHILLBUFF_GROW_DUPLICATIVE);
+    chillbuff_init(&attribute, 128, sizeof(unsigned char), CHILLBUFF_GROW_DUPLICATIVE);
+    chillbuff_init(&value, 64, sizeof(unsigned char), CHILLBUFF_GROW_DUPLICATIVE);
+
+    int ret = -1;
+
+    if (canonical.array == NULL || set.array == NULL || attribute.array == NULL || value.array == NULL)
+    {
+        goto exit;
+    }
+
+    /* Name ::= SEQUENCE OF RelativeDistinguishedName  and  RelativeDistinguishedName ::= SET OF AttributeTypeAndValue */
+    while (p < end)
+    {
+        if (mbedtls_asn1_get_tag(&p, end, &length, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET) != 0)
+        {
+            goto exit;
+        }
+
+        const unsigned char* set_end = p + length;
+        chillbuff_clear(&set);
+
+        while (p < set_end)
+        {
+            /* AttributeTypeAndValue ::= SEQUENCE { type OBJECT IDENTIFIER, value ANY } */
+            if (mbedtls_asn1_get_tag(&p, set_end, &length, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE) != 0)
+            {
+                goto exit;
+            }
+
+            const unsigned char* attribute_end = p + length;
+            const unsigned char* type = p;
+
+            if (mbedtls_asn1_get_tag(&p, attribute_end, &length, MBEDTLS_ASN1_OID) != 0)
+            {
+                goto exit;
+            }
+
+            p += length;
+
+            const unsigned char* type_end = p;
+
+            if (p >= attribute_end)
+            {
+                goto exit;
+            }
+
+            const unsigned char value_tag = *p++;
+            if (mbedtls_asn1_get_len(&p, attribute_end, &length) != 0)
+            {
+                goto exit;
+            }
+
+            const int canonicalized = canonicalize_value(value_tag, p, length, &value);
+            if (canonicalized < 0)
+            {
+                goto exit;
+            }
+
+            int pushed = CHILLBUFF_SUCCESS;
+
+            chillbuff_clear(&attribute);
+            pushed |= chillbuff_push_back(&attribute, type, type_end - type);
+
+            if (canonicalized == 0)
+            {
+                pushed |= push_der_header(&attribute, MBEDTLS_ASN1_UTF8_STRING, value.length);
+                pushed |= chillbuff_push_back(&attribute, value.array, value.length);
+            }
+            else
+            {
+                pushed |= push_der_header(&attribute, value_tag, length);
+                pushed |= chillbuff_push_back(&attribute, p, length);
+            }
+
+            pushed |= push_der_header(&set, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE, attribute.length);
+            pushed |= chillbuff_push_back(&set, attribute.array, attribute.length);
+
+            if (pushed != CHILLBUFF_SUCCESS)
+            {
+                goto exit;
+            }
+
+            p = (unsigned char*)attribute_end;
+        }
+
+        if (push_der_header(&canonical, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SET, set.length) != CHILLBUFF_SUCCESS || chillbuff_push_back(&canonical, set.array, set.length) != CHILLBUFF_SUCCESS)
+        {
+            goto exit;
+        }
+    }
+
+    unsigned char sha1[20];
+
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    ret = mbedtls_sha1(canonical.array, canonical.length, sha1);
+#else
+    ret = mbedtls_sha1_ret(canonical.array, canonical.length, sha1);
+#endif
+
+    *hash = (uint32_t)sha1[0] | (uint32_t)sha1[1] << 8 | (uint32_t)sha1[2] << 16 | (uint32_t)sha1[3] << 24;
+
+exit:
+    chillbuff_free(&canonical);
+    chillbuff_free(&set);
+    chillbuff_free(&attribute);
+    chillbuff_free(&value);
+    return ret;
+}
+
+/**
+ * @private
+ * Looks up the candidate issuers of a certificate inside the hashed CA certificates directory: <code>&lt;hash&gt;.0</code>, <code>&lt;hash&gt;.1</code>, ... until there's no such file.
+ */
+static int lookup_directory(const mbedtls_x509_crt* child, mbedtls_x509_crt** candidates)
+{
+    uint32_t hash;
+    if (openssl_name_hash(child->issuer_raw.p, child->issuer_raw.len, &hash) != 0)
+    {
+        return 0;
+    }
+
+    mbedtls_x509_crt* chain = mbedtls_calloc(1, sizeof(mbedtls_x509_crt));
+    if (chain == NULL)
+    {
+        return MBEDTLS_ERR_X509_ALLOC_FAILED;
+    }
+
+    mbedtls_x509_crt_init(chain);
+
+    char path[1024];
+
+    for (unsigned int i = 0;; ++i)
+    {
+        if (snprintf(path, sizeof(path), "%s/%08lx.%u", ca_certs_dir, (unsigned long)hash, i) >= (int)sizeof(path))
+        {
+            break;
+        }
+
+        /* The file not being there (anymore) simply ends the lookup. Files that can't be parsed are skipped (hash collisions are sorted out by mbedtls when it checks the candidates). */
+        const int ret = mbedtls_x509_crt_parse_file(chain, path);
+        if (ret == MBEDTLS_ERR_PK_FILE_IO_ERROR)
+        {
+            break;
+        }
+
+        if (ret == MBEDTLS_ERR_X509_ALLOC_FAILED)
+        {
+            mbedtls_x509_crt_free(chain);
+            mbedtls_free(chain);
+            return ret;
+        }
+    }
+
+    if (chain->raw.p == NULL)
+    {
+        mbedtls_free(chain);
+        return 0;
+    }
+
+    *candidates = chain;
+    return 0;
+}
+
+int glitchedhttps_truststore_init()
+{
+    glitchedhttps_truststore_free();
+
+    ca_certs_dir = glitchedhttps_get_ca_certs_dir();
+    if (ca_certs_dir != NULL)
+    {
+        return GLITCHEDHTTPS_SUCCESS;
+    }
+
+    size_t der_count = 0;
+    const size_t* der_lengths = NULL;
+    const unsigned char* der = glitchedhttps_get_ca_certs_der(&der_lengths, &der_count);
+
+    if (der == NULL || der_count == 0)
+    {
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    slots_count = 16;
+    while (slots_count < der_count * 2)
+    {
+        slots_count <<= 1;
+    }
+
+    roots = malloc(der_count * sizeof(struct trusted_root));
+    slots = calloc(slots_count, sizeof(size_t));
+    next = calloc(der_count, sizeof(size_t));
+
+    if (roots == NULL || slots == NULL || next == NULL)
+    {
+        glitchedhttps_log_error("OUT OF MEMORY!", __func__);
+        glitchedhttps_truststore_free();
+        return GLITCHEDHTTPS_OUT_OF_MEM;
+    }
+
+    for (size_t i = 0; i < der_count; der += der_lengths[i++])
+    {
+        struct trusted_root* root = &roots[roots_count];
+        root->der = der;
+        root->der_length = der_lengths[i];
+
+        /* Roots whose subject can't be found would never be parsed successfully either. */
+        if (find_subject(root->der, root->der_length, &root->subject, &root->subject_length) != 0)
+        {
+            continue;
+        }
+
+        const size_t index = roots_count++;
+        size_t slot = hash_name(root->subject, root->subject_length) & (slots_count - 1);
+
+        while (slots[slot] != 0 && !root_has_subject(&roots[slots[slot] - 1], root->subject, root->subject_length))
+        {
+            slot = (slot + 1) & (slots_count - 1);
+        }
+
+        if (slots[slot] == 0)
+        {
+            slots[slot] = index + 1;
+            continue;
+        }
+
+        size_t last = slots[slot] - 1;
+        while (next[last] != 0)
+        {
+            last = next[last] - 1;
+        }
+        next[last] = index + 1;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+size_t glitchedhttps_truststore_count()
+{
+    return roots_count;
+}
+
+int glitchedhttps_truststore_ca_cb(void* ctx, const mbedtls_x509_crt* child, mbedtls_x509_crt** candidates)
+{
+    (void)ctx;
+    *candidates = NULL;
+
+    if (ca_certs_dir != NULL)
+    {
+        return lookup_directory(child, candidates);
+    }
+
+    if (slots == NULL)
+    {
+        return 0;
+    }
+
+    const unsigned char* issuer = child->issuer_raw.p;
+    const size_t issuer_length = child->issuer_raw.len;
+
+    size_t slot = hash_name(issuer, issuer_length) & (slots_count - 1);
+
+    while (slots[slot] != 0 && !root_has_subject(&roots[slots[slot] - 1], issuer, issuer_length))
+    {
+        slot = (slot + 1) & (slots_count - 1);
+    }
+
+    /* Most lookups end here: a leaf certificate's issuer is usually an intermediate CA that the server sends along. */
+    if (slots[slot] == 0)
+    {
+        return 0;
+    }
+
+    /* mbedtls frees the candidates once it's done with them (with mbedtls_x509_crt_free() followed by mbedtls_free()). */
+    mbedtls_x509_crt* chain = mbedtls_calloc(1, sizeof(mbedtls_x509_crt));
+    if (chain == NULL)
+    {
+        return MBEDTLS_ERR_X509_ALLOC_FAILED;
+    }
+
+    mbedtls_x509_crt_init(chain);
+
+    for (size_t i = slots[slot]; i != 0; i = next[i - 1])
+    {
+        const struct trusted_root* root = &roots[i - 1];
+
+        /* The DER blob is static, so the parsed certificate can just point into it. A root that this mbedtls build can't parse is left out (just like when parsing the whole bundle). */
+        const int ret = mbedtls_x509_crt_parse_der_nocopy(chain, root->der, root->der_length);
+        if (ret == MBEDTLS_ERR_X509_ALLOC_FAILED)
+        {
+            mbedtls_x509_crt_free(chain);
+            mbedtls_free(chain);
+            return ret;
+        }
+    }
+
+    if (chain->raw.p == NULL)
+    {
+        mbedtls_free(chain);
+        return 0;
+    }
+
+    *candidates = chain;
+    return 0;
+}
+
+void glitchedhttps_truststore_free()
+{
+    free(roots);
+    free(slots);
+    free(next);
+
+    roots = NULL;
+    slots = NULL;
+    next = NULL;
+    ca_certs_dir = NULL;
+    roots_count = 0;
+    slots_count = 0;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
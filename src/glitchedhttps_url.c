@@ -0,0 +1,193 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "glitchedhttps_url.h"
+#include "glitchedhttps_exitcodes.h"
+#include "glitchedhttps_debug.h"
+#include "glitchedhttps_strutil.h"
+#include <stdio.h>
+#include <string.h>
+
+/** @private Finds the first occurrence of any of the characters in \p set (or \p end if there's none). */
+static const char* find_any(const char* begin, const char* end, const char* set)
+{
+    for (const char* c = begin; c < end; ++c)
+    {
+        if (strchr(set, *c) != NULL)
+        {
+            return c;
+        }
+    }
+    return end;
+}
+
+/** @private */
+static int parse_port(const char* begin, const char* end, int* port)
+{
+    int value = 0;
+
+    for (const char* c = begin; c < end; ++c)
+    {
+        if (*c < '0' || *c > '9' || value > 65535)
+        {
+            value = -1;
+            break;
+        }
+        value = value * 10 + (*c - '0');
+    }
+
+    if (value <= 0 || value > 65535)
+    {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Invalid port number \"%.*s\"", (int)(end - begin < 16 ? end - begin : 16), begin);
+        glitchedhttps_log_error(msg, __func__);
+        return GLITCHEDHTTPS_INVALID_PORT_NUMBER;
+    }
+
+    *port = value;
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+int glitchedhttps_url_parse(const char* url, size_t url_length, struct glitchedhttps_url* out)
+{
+    if (url == NULL || out == NULL)
+    {
+        glitchedhttps_log_error("URL or output parameter NULL!", __func__);
+        return GLITCHEDHTTPS_NULL_ARG;
+    }
+
+    if (url_length == 0)
+    {
+        url_length = strlen(url);
+    }
+
+    const char* const end = url + url_length;
+    memset(out, 0x00, sizeof(struct glitchedhttps_url));
+
+    /* Scheme. */
+
+    if (url_length >= 8 && glitchedhttps_strnequalic(url, "https://", 8))
+    {
+        out->https = 1;
+        out->scheme_length = 5;
+    }
+    else if (url_length >= 7 && glitchedhttps_strnequalic(url, "http://", 7))
+    {
+        out->https = 0;
+        out->scheme_length = 4;
+    }
+    else
+    {
+        glitchedhttps_log_error("Missing or invalid protocol in passed URL: needs to be \"http://\" or \"https://\"", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    out->scheme = url;
+
+    /* Authority: everything up to the path, query or fragment. */
+
+    const char* authority = url + out->scheme_length + 3;
+    const char* authority_end = find_any(authority, end, "/?#");
+
+    /* Skip the user info (if any): the last '@' separates it from the host. */
+    for (const char* c = authority_end; c > authority; --c)
+    {
+        if (c[-1] == '@')
+        {
+            authority = c;
+            break;
+        }
+    }
+
+    const char* port = NULL;
+
+    if (authority < authority_end && *authority == '[')
+    {
+        const char* bracket = memchr(authority, ']', authority_end - authority);
+        if (bracket == NULL)
+        {
+            glitchedhttps_log_error("Invalid URL: unterminated IPv6 address!", __func__);
+            return GLITCHEDHTTPS_INVALID_ARG;
+        }
+
+        out->host = authority + 1;
+        out->host_length = bracket - out->host;
+
+        if (bracket + 1 < authority_end)
+        {
+            if (bracket[1] != ':')
+            {
+                glitchedhttps_log_error("Invalid URL: unexpected characters after IPv6 address!", __func__);
+                return GLITCHEDHTTPS_INVALID_ARG;
+            }
+            port = bracket + 2;
+        }
+    }
+    else
+    {
+        const char* colon = memchr(authority, ':', authority_end - authority);
+
+        out->host = authority;
+        out->host_length = (colon != NULL ? colon : authority_end) - authority;
+        port = colon != NULL ? colon + 1 : NULL;
+    }
+
+    if (out->host_length == 0)
+    {
+        glitchedhttps_log_error("Invalid URL: empty host!", __func__);
+        return GLITCHEDHTTPS_INVALID_ARG;
+    }
+
+    out->port = out->https ? 443 : 80;
+
+    /* An empty port ("host:/path") means the default port. */
+    if (port != NULL && port < authority_end)
+    {
+        const int r = parse_port(port, authority_end, &out->port);
+        if (r != GLITCHEDHTTPS_SUCCESS)
+        {
+            return r;
+        }
+    }
+
+    out->authority = authority;
+    out->authority_length = authority_end - authority;
+
+    /* Path, query and fragment. */
+
+    const char* fragment = memchr(authority_end, '#', end - authority_end);
+    const char* resource_end = fragment != NULL ? fragment : end;
+    const char* query = memchr(authority_end, '?', resource_end - authority_end);
+
+    out->path = authority_end;
+    out->path_length = (query != NULL ? query : resource_end) - authority_end;
+
+    if (query != NULL)
+    {
+        out->query = query + 1;
+        out->query_length = resource_end - out->query;
+    }
+
+    return GLITCHEDHTTPS_SUCCESS;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
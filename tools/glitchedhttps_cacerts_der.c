@@ -0,0 +1,282 @@
+/*
+   Copyright 2020 Raphael Beck
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+
+/*
+ *  Build-time tool: converts every PEM certificate inside a text file (by default the bundle at the bottom of src/glitchedhttps_cacerts.c)
+ *  into DER and writes them out as a C source file that gets compiled into the library:
+ *
+ *      const unsigned char glitchedhttps_cacerts_der[];        All certificates, back to back.
+ *      const size_t glitchedhttps_cacerts_der_lengths[];       The length of each certificate inside the blob.
+ *      const size_t glitchedhttps_cacerts_der_count;           The amount of certificates.
+ *
+ *  Usage: glitchedhttps_cacerts_der <input PEM bundle> <output .c file>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINE_SIZE 1024
+
+static const char pem_begin[] = "-----BEGIN CERTIFICATE-----";
+static const char pem_end[] = "-----END CERTIFICATE-----";
+
+struct der_bundle
+{
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+    size_t* lengths;
+    size_t count;
+    size_t lengths_capacity;
+};
+
+static int base64_value(const char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+')
+        return 62;
+    if (c == '/')
+        return 63;
+    return -1;
+}
+
+static int reserve(struct der_bundle* bundle, const size_t additional)
+{
+    if (bundle->length + additional <= bundle->capacity)
+    {
+        return 0;
+    }
+
+    size_t capacity = bundle->capacity > 0 ? bundle->capacity : 256 * 1024;
+    while (capacity < bundle->length + additional)
+    {
+        capacity *= 2;
+    }
+
+    unsigned char* data = realloc(bundle->data, capacity);
+    if (data == NULL)
+    {
+        return 1;
+    }
+
+    bundle->data = data;
+    bundle->capacity = capacity;
+    return 0;
+}
+
+/* Decodes one line of base64 and appends it to the bundle, carrying the partial 24-bit group over to the next line. */
+static int decode_line(struct der_bundle* bundle, const char* line, unsigned int* group, int* group_length)
+{
+    if (reserve(bundle, strlen(line)) != 0)
+    {
+        return 1;
+    }
+
+    for (const char* c = line; *c != '\0'; ++c)
+    {
+        if (*c == '=')
+        {
+            break;
+        }
+
+        const int value = base64_value(*c);
+        if (value < 0)
+        {
+            if (*c == '\r' || *c == '\n' || *c == ' ' || *c == '\t')
+                continue;
+            return 1;
+        }
+
+        *group = (*group << 6) | (unsigned int)value;
+
+        if (++*group_length == 4)
+        {
+            bundle->data[bundle->length++] = (unsigned char)(*group >> 16);
+            bundle->data[bundle->length++] = (unsigned char)(*group >> 8);
+            bundle->data[bundle->length++] = (unsigned char)(*group);
+            *group = 0;
+            *group_length = 0;
+        }
+    }
+
+    return 0;
+}
+
+/* Flushes the last (padded) base64 group of a certificate. */
+static void decode_final(struct der_bundle* bundle, const unsigned int group, const int group_length)
+{
+    if (group_length == 2)
+    {
+        bundle->data[bundle->length++] = (unsigned char)(group >> 4);
+    }
+    else if (group_length == 3)
+    {
+        bundle->data[bundle->length++] = (unsigned char)(group >> 10);
+        bundle->data[bundle->length++] = (unsigned char)(group >> 2);
+    }
+}
+
+static int push_length(struct der_bundle* bundle, const size_t length)
+{
+    if (bundle->count == bundle->lengths_capacity)
+    {
+        const size_t capacity = bundle->lengths_capacity > 0 ? bundle->lengths_capacity * 2 : 256;
+
+        size_t* lengths = realloc(bundle->lengths, capacity * sizeof(size_t));
+        if (lengths == NULL)
+        {
+            return 1;
+        }
+
+        bundle->lengths = lengths;
+        bundle->lengths_capacity = capacity;
+    }
+
+    bundle->lengths[bundle->count++] = length;
+    return 0;
+}
+
+static int read_bundle(FILE* input, struct der_bundle* bundle)
+{
+    char line[LINE_SIZE];
+    int in_certificate = 0;
+    unsigned int group = 0;
+    int group_length = 0;
+    size_t certificate_start = 0;
+
+    while (fgets(line, sizeof(line), input) != NULL)
+    {
+        if (!in_certificate)
+        {
+            if (strncmp(line, pem_begin, sizeof(pem_begin) - 1) == 0)
+            {
+                in_certificate = 1;
+                group = 0;
+                group_length = 0;
+                certificate_start = bundle->length;
+            }
+            continue;
+        }
+
+        if (strncmp(line, pem_end, sizeof(pem_end) - 1) == 0)
+        {
+            decode_final(bundle, group, group_length);
+            in_certificate = 0;
+
+            /* Every X.509 certificate is a DER SEQUENCE: anything else means the PEM block was broken. */
+            if (bundle->length - certificate_start < 2 || bundle->data[certificate_start] != 0x30)
+            {
+                fprintf(stderr, "glitchedhttps_cacerts_der: certificate #%zu is not valid DER\n", bundle->count + 1);
+                return 1;
+            }
+
+            if (push_length(bundle, bundle->length - certificate_start) != 0)
+            {
+                return 1;
+            }
+            continue;
+        }
+
+        if (decode_line(bundle, line, &group, &group_length) != 0)
+        {
+            fprintf(stderr, "glitchedhttps_cacerts_der: invalid base64 in certificate #%zu\n", bundle->count + 1);
+            return 1;
+        }
+    }
+
+    if (in_certificate)
+    {
+        fprintf(stderr, "glitchedhttps_cacerts_der: unterminated PEM certificate at the end of the input\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int write_source(FILE* output, const struct der_bundle* bundle)
+{
+    fprintf(output, "/* Generated by tools/glitchedhttps_cacerts_der.c at build time: do not edit! */\n\n");
+    fprintf(output, "#include <stddef.h>\n\n");
+
+    /* An empty array isn't valid C: keep at least one (unused) byte in there. */
+    fprintf(output, "const unsigned char glitchedhttps_cacerts_der[%zu] = {", bundle->length > 0 ? bundle->length : 1);
+    for (size_t i = 0; i < bundle->length; ++i)
+    {
+        fprintf(output, i % 16 == 0 ? "\n    0x%02x," : " 0x%02x,", bundle->data[i]);
+    }
+    fprintf(output, "%s\n};\n\n", bundle->length > 0 ? "" : "\n    0x00");
+
+    fprintf(output, "const size_t glitchedhttps_cacerts_der_lengths[%zu] = {", bundle->count > 0 ? bundle->count : 1);
+    for (size_t i = 0; i < bundle->count; ++i)
+    {
+        fprintf(output, i % 8 == 0 ? "\n    %zu," : " %zu,", bundle->lengths[i]);
+    }
+    fprintf(output, "%s\n};\n\n", bundle->count > 0 ? "" : "\n    0");
+
+    fprintf(output, "const size_t glitchedhttps_cacerts_der_count = %zu;\n", bundle->count);
+
+    return ferror(output) ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <input PEM bundle> <output .c file>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* input = fopen(argv[1], "r");
+    if (input == NULL)
+    {
+        fprintf(stderr, "glitchedhttps_cacerts_der: couldn't open \"%s\"\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    struct der_bundle bundle;
+    memset(&bundle, 0x00, sizeof(bundle));
+
+    int exit_code = read_bundle(input, &bundle);
+    fclose(input);
+
+    if (exit_code == 0)
+    {
+        FILE* output = fopen(argv[2], "w");
+        if (output == NULL)
+        {
+            fprintf(stderr, "glitchedhttps_cacerts_der: couldn't open \"%s\" for writing\n", argv[2]);
+            exit_code = 1;
+        }
+        else
+        {
+            exit_code = write_source(output, &bundle);
+            exit_code |= fclose(output) != 0;
+        }
+    }
+
+    free(bundle.data);
+    free(bundle.lengths);
+
+    return exit_code == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#undef LINE_SIZE